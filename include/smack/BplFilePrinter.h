@@ -4,6 +4,7 @@
 #ifndef BPLFILEPRINTER_H
 #define BPLFILEPRINTER_H
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Pass.h"
 
 namespace smack {
@@ -12,6 +13,8 @@ class BplFilePrinter : public llvm::ModulePass {
 private:
   llvm::raw_ostream &out;
 
+  void printLine(llvm::StringRef line);
+
 public:
   static char ID; // Pass identification, replacement for typeid
 
@@ -25,6 +25,9 @@ private:
   seadsa::Graph *DG;
   std::unordered_set<const seadsa::Node *> staticInits;
   std::unordered_set<const seadsa::Node *> memOpds;
+  // The nodes which may be accessed by more than one thread.
+  std::unordered_set<const seadsa::Node *> threadShared;
+  bool createsThreads;
   // Mapping from the DSNodes associated with globals to the numbers of
   // globals associated with them.
   std::unordered_map<const seadsa::Node *, unsigned> globalRefCount;
@@ -33,6 +36,7 @@ private:
   void collectStaticInits(llvm::Module &M);
   void collectMemOpds(llvm::Module &M);
   void countGlobalRefs();
+  void collectThreadShared(llvm::Module &M);
 
 public:
   static char ID;
@@ -43,6 +47,7 @@ public:
 
   bool isStaticInitd(const seadsa::Node *n);
   bool isMemOpd(const seadsa::Node *n);
+  bool isThreadLocal(const seadsa::Node *n);
   bool isRead(const llvm::Value *V);
   bool isSingletonGlobal(const llvm::Value *V);
   unsigned getPointedTypeSize(const llvm::Value *v);
@@ -0,0 +1,32 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+#ifndef INLINELEAFFUNCTIONS_H
+#define INLINELEAFFUNCTIONS_H
+
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include <set>
+
+namespace smack {
+
+class InlineLeafFunctions : public llvm::ModulePass {
+private:
+  std::set<llvm::Function *> leaves;
+  unsigned numInlined = 0;
+
+  unsigned getCost(llvm::Function &F);
+  bool isInlinable(llvm::Function &F);
+  bool canInline(llvm::CallInst &CI);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  InlineLeafFunctions() : llvm::ModulePass(ID) {}
+  virtual llvm::StringRef getPassName() const override;
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+  virtual bool runOnModule(llvm::Module &M) override;
+};
+} // namespace smack
+
+#endif // INLINELEAFFUNCTIONS_H
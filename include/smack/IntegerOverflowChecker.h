@@ -28,6 +28,8 @@ private:
   llvm::BinaryOperator *createFlag(llvm::Value *v, int bits, bool isSigned,
                                    llvm::Instruction *i);
   llvm::Value *createResult(llvm::Value *v, int bits, llvm::Instruction *i);
+  llvm::Value *createPredicate(std::string op, int bits, bool isSigned,
+                               llvm::CallInst *ci);
   void addCheck(llvm::Function *co, llvm::Value *flag, llvm::Instruction *i);
   void addBlockingAssume(llvm::Function *va, llvm::Value *flag,
                          llvm::Instruction *i);
@@ -0,0 +1,40 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+#ifndef INTEGERWRAPELIMINATION_H
+#define INTEGERWRAPELIMINATION_H
+
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include <map>
+
+namespace smack {
+
+class IntegerWrapElimination : public llvm::FunctionPass {
+private:
+  enum Fact : unsigned { SIGNED = 1, UNSIGNED = 2 };
+  std::map<const llvm::Value *, unsigned> facts;
+  unsigned numWraps = 0;
+  unsigned numEliminated = 0;
+
+  unsigned getFacts(const llvm::Value *V, bool isUnsigned,
+                    bool isUnsignedInst);
+  unsigned getFacts(llvm::Instruction *I, unsigned opIdx);
+  unsigned getRangeFacts(llvm::Value *V, llvm::Instruction *I, unsigned f);
+  bool fits(llvm::Instruction *I, bool isSigned);
+  bool isWrapFree(llvm::Instruction *I);
+  unsigned transfer(llvm::Instruction *I);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  IntegerWrapElimination() : llvm::FunctionPass(ID) {}
+  virtual llvm::StringRef getPassName() const override;
+  virtual bool runOnFunction(llvm::Function &F) override;
+  virtual bool doFinalization(llvm::Module &M) override;
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+  static bool isMarked(const llvm::Instruction &I);
+};
+} // namespace smack
+
+#endif // INTEGERWRAPELIMINATION_H
@@ -0,0 +1,52 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+#ifndef LAZYSEQUENTIALIZATION_H
+#define LAZYSEQUENTIALIZATION_H
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include <set>
+#include <vector>
+
+namespace smack {
+
+class LazySequentialization : public llvm::ModulePass {
+private:
+  llvm::Module *M;
+  unsigned numThreads;
+  std::set<llvm::Function *> recursive;
+
+  llvm::GlobalVariable *getThreadGlobal(llvm::StringRef name);
+  llvm::Value *getCurrentThread(llvm::IRBuilder<> &B);
+  llvm::Value *getThreadSlot(llvm::IRBuilder<> &B, llvm::StringRef name,
+                             llvm::Value *tid);
+  bool isLibrary(const llvm::Function *F);
+  std::set<llvm::Function *> reachable(std::vector<llvm::Function *> roots);
+  void markContextSwitches(std::vector<llvm::Function *> threads,
+                           std::vector<llvm::Function *> routines);
+  void inlineCalls(llvm::Function *F);
+  void reacquireMutexes(llvm::Function *F);
+  void splitReturns(llvm::Function *F);
+  std::vector<llvm::BasicBlock *> splitContextSwitches(llvm::Function *F);
+  void makeResumable(llvm::Function *F,
+                     const std::vector<llvm::BasicBlock *> &resumes);
+  void demoteRegisters(llvm::Function *F);
+  void privatizeLocals(llvm::Function *F);
+  void sequentialize(llvm::Function *F);
+  void createScheduler(llvm::Function *main, llvm::Function *mainThread,
+                       const std::vector<llvm::Function *> &routines,
+                       const std::vector<llvm::Function *> &threads);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  LazySequentialization() : llvm::ModulePass(ID) {}
+  virtual llvm::StringRef getPassName() const override;
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+  virtual bool runOnModule(llvm::Module &M) override;
+};
+} // namespace smack
+
+#endif // LAZYSEQUENTIALIZATION_H
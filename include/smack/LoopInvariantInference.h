@@ -0,0 +1,63 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+#ifndef LOOPINVARIANTINFERENCE_H
+#define LOOPINVARIANTINFERENCE_H
+
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Pass.h"
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace smack {
+
+class LoopInvariantInference : public llvm::FunctionPass {
+public:
+  // The invariant `phi <= bound + offset`, or `phi >= bound + offset` unless
+  // `upper`, over the representatives of integer values. A constant bound
+  // is represented by a null `bound`. When `init` is not null, the invariant
+  // is conditional on it holding for the value `init` on loop entry.
+  struct Invariant {
+    const llvm::PHINode *phi;
+    bool upper;
+    const llvm::Value *bound;
+    bool isUnsigned;
+    int64_t offset;
+    const llvm::Value *init;
+  };
+
+  // An interval of integers, possibly unbounded or empty.
+  struct Interval {
+    bool empty = true;
+    bool hasLower = false, hasUpper = false;
+    int64_t lower = 0, upper = 0;
+  };
+
+private:
+  llvm::DominatorTree *DT;
+  std::map<const llvm::Value *, Interval> intervals;
+  std::map<const llvm::BasicBlock *, std::vector<Invariant>> invariants;
+
+  Interval getInterval(const llvm::Value *V, const llvm::Instruction *I);
+  Interval getInterval(const llvm::Value *V, const llvm::BasicBlock *B,
+                       bool isUnsigned, bool isUnsignedInst);
+  Interval refine(const llvm::Value *V, Interval R, const llvm::BasicBlock *P,
+                  const llvm::BasicBlock *S);
+  Interval transfer(const llvm::Instruction *I);
+  bool inferIntervals(llvm::Function &F);
+  void inferRelations(const llvm::Loop *L);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  LoopInvariantInference() : llvm::FunctionPass(ID) {}
+  virtual llvm::StringRef getPassName() const override;
+  virtual bool runOnFunction(llvm::Function &F) override;
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+  const std::vector<Invariant> &getInvariants(const llvm::BasicBlock *H);
+};
+} // namespace smack
+
+#endif // LOOPINVARIANTINFERENCE_H
@@ -4,28 +4,49 @@
 #ifndef MEMORYSAFETYCHECKER_H
 #define MEMORYSAFETYCHECKER_H
 
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
 #include <map>
+#include <vector>
 
 namespace smack {
 
 class MemorySafetyChecker : public llvm::FunctionPass,
                             public llvm::InstVisitor<MemorySafetyChecker> {
 private:
+  // A call to the memory-safety check function, which checks the access of
+  // size bytes at addr; size is an integer-typed value.
+  struct AccessCheck {
+    llvm::CallInst *call;
+    llvm::Value *addr;
+    llvm::Value *size;
+  };
+  std::vector<AccessCheck> checks;
+
   llvm::Function *getLeakCheckFunction(llvm::Module &M);
   llvm::Function *getSafetyCheckFunction(llvm::Module &M);
 
   void copyDbgMetadata(llvm::Instruction *src, llvm::Instruction *dst);
   void insertMemoryLeakCheck(llvm::Instruction *I);
-  void insertMemoryAccessCheck(llvm::Value *addr, llvm::Value *size,
-                               llvm::Instruction *I);
+  llvm::CallInst *insertMemoryAccessCheck(llvm::Value *addr, llvm::Value *size,
+                                          llvm::Instruction *I);
+  void removeMemoryAccessCheck(AccessCheck &C);
+
+  bool covers(const AccessCheck &C1, const AccessCheck &C2);
+  void hoistLoopChecks(llvm::Loop *L, llvm::DominatorTree &DT,
+                       llvm::LoopInfo &LI, llvm::ScalarEvolution &SE);
+  void removeRedundantChecks(llvm::Function &F, llvm::DominatorTree &DT,
+                             llvm::LoopInfo &LI);
 
 public:
   static char ID; // Pass identification, replacement for typeid
   MemorySafetyChecker() : llvm::FunctionPass(ID) {}
   virtual bool runOnFunction(llvm::Function &F) override;
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
 
   void visitReturnInst(llvm::ReturnInst &I);
   void visitLoadInst(llvm::LoadInst &I);
@@ -0,0 +1,32 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+#ifndef MERGEIDENTICALFUNCTIONS_H
+#define MERGEIDENTICALFUNCTIONS_H
+
+#include "smack/DSAWrapper.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+namespace smack {
+
+class MergeIdenticalFunctions : public llvm::ModulePass {
+private:
+  DSAWrapper *DSA;
+  unsigned numMerged = 0;
+  unsigned numThunks = 0;
+
+  bool isMergeable(llvm::Function &F);
+  bool translatesAlike(llvm::Function &F, llvm::Function &G);
+  void merge(llvm::Function *F, llvm::Function *G);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  MergeIdenticalFunctions() : llvm::ModulePass(ID) {}
+  virtual llvm::StringRef getPassName() const override;
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+  virtual bool runOnModule(llvm::Module &M) override;
+};
+} // namespace smack
+
+#endif // MERGEIDENTICALFUNCTIONS_H
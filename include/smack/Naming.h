@@ -73,6 +73,7 @@ public:
 
   static const std::string BRANCH_CONDITION_ANNOTATION;
   static const std::string LOOP_INVARIANT_ANNOTATION;
+  static const std::string THREAD_LOCAL_ANNOTATION;
 
   static const std::string MEM_OP;
   static const std::string REC_MEM_OP;
@@ -93,6 +94,7 @@ public:
   static const std::string CONTRACT_EXPR;
   static const std::string MEMORY_SAFETY_FUNCTION;
   static const std::string MEMORY_LEAK_FUNCTION;
+  static const std::string OVERFLOW_PREDICATE;
 
   static const std::string RUST_ENTRY;
   static const std::string RUST_LANG_START_INTERNAL;
@@ -0,0 +1,31 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+#ifndef NARROWINTEGEROPS_H
+#define NARROWINTEGEROPS_H
+
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+namespace smack {
+
+class NarrowIntegerOps : public llvm::FunctionPass {
+private:
+  unsigned numOps = 0;
+  unsigned numNarrowed = 0;
+
+  unsigned getNarrowWidth(llvm::BinaryOperator *I, bool &isSigned);
+  void narrow(llvm::BinaryOperator *I, unsigned width, bool isSigned);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  NarrowIntegerOps() : llvm::FunctionPass(ID) {}
+  virtual llvm::StringRef getPassName() const override;
+  virtual bool runOnFunction(llvm::Function &F) override;
+  virtual bool doFinalization(llvm::Module &M) override;
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+};
+} // namespace smack
+
+#endif // NARROWINTEGEROPS_H
@@ -128,6 +128,7 @@ struct IntOpGen : public TypeGen {
   void generateConvOps(std::stringstream &s) const override;
   void generateExtractValueFuncs(std::stringstream &s) const override;
   void generateBvIntConvs(std::stringstream &s) const;
+  void generateOverflowPreds(std::stringstream &s) const;
   void generate(std::stringstream &s) const override;
 };
 
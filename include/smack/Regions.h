@@ -32,6 +32,7 @@ private:
   bool incomplete;
   bool complicated;
   bool collapsed;
+  bool threadLocal;
 
   static const DataLayout *DL;
   static DSAWrapper *DSA;
@@ -55,6 +56,7 @@ public:
   bool isSingleton() const { return singleton; };
   bool isAllocated() const { return allocated; };
   bool bytewiseAccess() const { return bytewise; }
+  bool isThreadLocal() const { return threadLocal; }
   const Type *getType() const { return type; }
 
   void print(raw_ostream &);
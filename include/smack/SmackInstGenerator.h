@@ -19,6 +19,7 @@ class Stmt;
 class Expr;
 class Attr;
 class SmackRep;
+class LoopInvariantInference;
 
 class SmackInstGenerator : public llvm::InstVisitor<SmackInstGenerator> {
 
@@ -27,6 +28,7 @@ private:
   SmackRep *rep;
   ProcDecl *proc;
   Naming *naming;
+  LoopInvariantInference *invariants;
 
   Block *currBlock;
   llvm::BasicBlock::const_iterator nextInst;
@@ -43,6 +45,7 @@ private:
   void processInstruction(llvm::Instruction &i);
   void nameInstruction(llvm::Instruction &i);
   void annotate(llvm::Instruction &i, Block *b);
+  void generateLoopInvariants(llvm::BasicBlock &bb);
 
   const Stmt *recordProcedureCall(const llvm::Value *V,
                                   std::list<const Attr *> attrs);
@@ -51,8 +54,9 @@ public:
   void emit(const Stmt *s);
 
 public:
-  SmackInstGenerator(llvm::LoopInfo &LI, SmackRep *R, ProcDecl *P, Naming *N)
-      : loops(LI), rep(R), proc(P), naming(N) {}
+  SmackInstGenerator(llvm::LoopInfo &LI, SmackRep *R, ProcDecl *P, Naming *N,
+                     LoopInvariantInference *I = nullptr)
+      : loops(LI), rep(R), proc(P), naming(N), invariants(I) {}
 
   void visitBasicBlock(llvm::BasicBlock &bb);
   void visitInstruction(llvm::Instruction &i);
@@ -26,18 +26,32 @@ public:
   static const llvm::cl::opt<bool> SourceLocSymbols;
   static llvm::cl::opt<bool> BitPrecise;
   static const llvm::cl::opt<bool> BitPrecisePointers;
+  static const llvm::cl::opt<bool> BitVectorOverflowBuiltins;
+  static const llvm::cl::opt<bool> BitPreciseBitwiseOps;
   static const llvm::cl::opt<bool> RewriteBitwiseOps;
+  static const llvm::cl::opt<bool> ScalarizeVectors;
   static const llvm::cl::opt<bool> NoMemoryRegionSplitting;
   static const llvm::cl::opt<bool> NoByteAccessInference;
   static const llvm::cl::opt<bool> FloatEnabled;
   static const llvm::cl::opt<bool> MemorySafety;
   static const llvm::cl::opt<bool> IntegerOverflow;
   static const llvm::cl::opt<bool> FailOnLoopExit;
+  static const llvm::cl::opt<bool> InferLoopInvariants;
+  static const llvm::cl::opt<bool> LazySequentialization;
+  static const llvm::cl::opt<unsigned> SequentializationRounds;
+  static const llvm::cl::opt<bool> MergeFunctions;
+  static const llvm::cl::opt<bool> InlineLeafFunctions;
+  static const llvm::cl::opt<unsigned> InlineLeafThreshold;
   static const llvm::cl::opt<LLVMAssumeType> LLVMAssumes;
   static const llvm::cl::opt<bool> RustPanics;
   static const llvm::cl::opt<bool> AddTiming;
   static const llvm::cl::opt<bool> WrappedIntegerEncoding;
 
+  static const llvm::cl::list<std::string> BplHeader;
+  static const llvm::cl::opt<unsigned> InlineBound;
+  static const llvm::cl::list<std::string> InlinedProcedures;
+  static const llvm::cl::list<std::string> SelectedAssertions;
+
   static bool isEntryPoint(llvm::StringRef);
   static bool shouldCheckFunction(llvm::StringRef);
 };
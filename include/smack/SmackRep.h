@@ -132,6 +132,11 @@ public:
   std::string type(const llvm::Type *t);
   std::string type(const llvm::Value *v);
 
+  static bool isNegativeLit(const llvm::ConstantInt *ci, bool isUnsigned,
+                            bool isUnsignedInst);
+  static std::pair<bool, bool> litFlags(unsigned opcode,
+                                        bool isUnsigned = false);
+  static std::pair<bool, bool> litFlags(const llvm::Instruction *I);
   const Expr *lit(const llvm::Value *v, bool isUnsigned = false,
                   bool isUnsignedInst = false);
   const Expr *lit(const llvm::Value *v, unsigned flag);
@@ -163,6 +168,8 @@ public:
   const Expr *select(const llvm::SelectInst *I);
   const Expr *select(const llvm::ConstantExpr *CE);
 
+  const Expr *overflowPredicate(const llvm::CallInst &CI);
+
   const Expr *arg(llvm::Function *f, unsigned pos, llvm::Value *v);
   const Stmt *call(llvm::Function *f, const llvm::User &u);
   std::string code(llvm::CallInst &ci);
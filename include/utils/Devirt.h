@@ -24,7 +24,10 @@
 #include "llvm/IR/DataLayout.h"
 
 #include "seadsa/CompleteCallGraph.hh"
+#include "seadsa/DsaAnalysis.hh"
+#include "seadsa/Global.hh"
 
+#include <map>
 #include <set>
 
 using namespace llvm;
@@ -43,29 +46,40 @@ namespace llvm {
       // Access to analysis pass which finds targets of indirect function calls
       seadsa::CompleteCallGraph *CCG;
 
+      // Access to the points-to graphs used to narrow the call targets
+      seadsa::GlobalAnalysis *DSA;
+
       // Access to the target data analysis pass
       const DataLayout * TD;
 
       // Worklist of call sites to transform
       std::vector<CallBase *> Worklist;
 
-      // A cache of indirect call targets that have been converted already
-      std::map<const Function *, std::set<const Function *> > bounceCache;
+      // A cache of the bounce functions built already, indexed by their
+      // signature and the set of targets they dispatch over
+      typedef std::pair<FunctionType *, std::set<const Function *> > BounceKey;
+      std::map<BounceKey, Function *> bounceCache;
+
+      // The number of call targets before and after points-to refinement
+      unsigned NumTargetsFound;
+      unsigned NumTargetsKept;
 
     protected:
       void makeDirectCall (CallBase *CS);
-      Function* buildBounce (CallBase *CS,std::vector<const Function*>& Targets);
-      const Function* findInCache (const CallBase *CS,
-                                   std::set<const Function*>& Targets);
+      void refineTargets (CallBase *CS, std::vector<const Function*>& Targets);
+      FunctionType* getBounceType (CallBase *CS);
+      Function* buildBounce (CallBase *CS, FunctionType *NewTy,
+                             std::vector<const Function*>& Targets);
 
     public:
       static char ID;
-      Devirtualize() : ModulePass(ID) {}
+      Devirtualize() : ModulePass(ID), NumTargetsFound(0), NumTargetsKept(0) {}
 
       virtual bool runOnModule(Module & M) override;
 
       virtual void getAnalysisUsage(AnalysisUsage &AU) const override{
         AU.addRequired<seadsa::CompleteCallGraph>();
+        AU.addRequired<seadsa::DsaAnalysis>();
       }
 
       // Visitor methods for analyzing instructions
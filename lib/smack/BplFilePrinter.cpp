@@ -4,6 +4,8 @@
 #include "smack/BplFilePrinter.h"
 #include "smack/BoogieAst.h"
 #include "smack/SmackModuleGenerator.h"
+#include "smack/SmackOptions.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/GraphWriter.h"
 #include <sstream>
@@ -11,9 +13,69 @@
 namespace smack {
 
 using llvm::errs;
+using llvm::StringRef;
 
 char BplFilePrinter::ID = 0;
 
+namespace {
+// Returns the attribute which annotates the named procedure, if any.
+std::string procedureAttr(StringRef name) {
+  if (SmackOptions::isEntryPoint(name))
+    return "{:entrypoint}";
+
+  for (auto &P : SmackOptions::InlinedProcedures)
+    if (name.startswith(P))
+      return "{:inline 1}";
+
+  if (SmackOptions::InlineBound > 0)
+    return "{:inline " + std::to_string(SmackOptions::InlineBound) + "}";
+
+  return "";
+}
+
+bool isSelected(StringRef attr) {
+  for (auto &A : SmackOptions::SelectedAssertions)
+    if (attr == A)
+      return true;
+  return false;
+}
+
+bool isSpaceOrBrace(char c) { return llvm::isSpace(c) || c == '}'; }
+} // namespace
+
+// Prints the line of the program, annotating procedure declarations, including
+// those of the prelude and of inline code, and replacing the assertions which
+// are not selected.
+void BplFilePrinter::printLine(StringRef line) {
+  auto body = line.ltrim();
+  auto indent = line.take_front(line.size() - body.size());
+
+  if (body.consume_front("procedure") && !body.empty() &&
+      llvm::isSpace(body.front())) {
+    auto rest = body.ltrim();
+    auto name = rest.take_until(
+        [](char c) { return llvm::isSpace(c) || c == '('; });
+    auto attr = procedureAttr(name);
+    if (!name.empty() && rest.drop_front(name.size()).ltrim().startswith("(") &&
+        !attr.empty()) {
+      out << indent << "procedure " << attr << " " << rest << "\n";
+      return;
+    }
+
+  } else if (!SmackOptions::SelectedAssertions.empty() &&
+             body.consume_front("assert") && body.contains(';') &&
+             (llvm::isSpace(body.front()) || body.front() == '{')) {
+    auto rest = body.ltrim();
+    if (!rest.consume_front("{:") ||
+        !isSelected(rest.take_until(isSpaceOrBrace))) {
+      out << indent << "assert true;\n";
+      return;
+    }
+  }
+
+  out << line << "\n";
+}
+
 void BplFilePrinter::getAnalysisUsage(llvm::AnalysisUsage &AU) const {
   AU.setPreservesAll();
   AU.addRequired<SmackModuleGenerator>();
@@ -24,7 +86,19 @@ bool BplFilePrinter::runOnModule(llvm::Module &m) {
   Program *program = smackGenerator.getProgram();
   std::ostringstream s;
   program->print(s);
-  out << s.str();
+
+  for (auto &L : SmackOptions::BplHeader)
+    out << "// " << L << "\n";
+  if (!SmackOptions::BplHeader.empty())
+    out << "\n";
+
+  std::string bpl = s.str();
+  StringRef text = bpl;
+  while (!text.empty()) {
+    auto line = text.split('\n');
+    printLine(line.first);
+    text = line.second;
+  }
   // DEBUG_WITH_TYPE("bpl", errs() << "" << s.str());
   return false;
 }
@@ -38,6 +38,7 @@ bool DSAWrapper::runOnModule(llvm::Module &M) {
   collectStaticInits(M);
   collectMemOpds(M);
   countGlobalRefs();
+  collectThreadShared(M);
   module = &M;
   return false;
 }
@@ -77,6 +78,34 @@ void DSAWrapper::countGlobalRefs() {
   }
 }
 
+// A thread-escape analysis: the nodes reachable from globals and from the
+// arguments passed to started threads are shared between threads. All other
+// nodes, e.g., the stack frames of thread functions and heap objects which
+// never escape the thread that allocated them, are thread local.
+void DSAWrapper::collectThreadShared(llvm::Module &M) {
+  auto create = M.getFunction("pthread_create");
+  createsThreads = create != nullptr;
+  if (!createsThreads)
+    return;
+
+  std::vector<const seadsa::Node *> worklist;
+  for (auto &g : DG->globals())
+    worklist.push_back(g.second->getNode());
+  for (auto U : create->users())
+    if (auto CI = dyn_cast<CallInst>(U))
+      if (auto N = getNode(CI->getArgOperand(3)))
+        worklist.push_back(N);
+
+  while (!worklist.empty()) {
+    auto N = worklist.back();
+    worklist.pop_back();
+    if (!N || !threadShared.insert(N).second)
+      continue;
+    for (auto &link : N->getLinks())
+      worklist.push_back(link.second->getNode());
+  }
+}
+
 bool DSAWrapper::isStaticInitd(const seadsa::Node *n) {
   return staticInits.count(n) > 0;
 }
@@ -85,6 +114,10 @@ bool DSAWrapper::isMemOpd(const seadsa::Node *n) {
   return memOpds.count(n) > 0;
 }
 
+bool DSAWrapper::isThreadLocal(const seadsa::Node *n) {
+  return createsThreads && !threadShared.count(n);
+}
+
 bool DSAWrapper::isRead(const Value *V) {
   auto node = getNode(V);
   assert(node && "Global values should have nodes.");
@@ -0,0 +1,186 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+
+//
+// This pass inlines small non-recursive leaf functions, e.g., getters,
+// wrappers, and the runtime helpers of smack.c, into their callers. The
+// verifiers inline every procedure call anyway, so inlining before the
+// translation does not duplicate any code; it removes the procedure frame of
+// each call, i.e., the copying of arguments and of the return value.
+//
+// Functions are visited bottom-up in the call graph, so a function whose
+// callees are all inlined becomes a leaf itself. A leaf calls declarations
+// only, and contains no loops. Its cost estimates the contribution of its body
+// to the verification condition rather than its code size, and it is inlined
+// when that cost stays within the threshold plus the size of its frame.
+//
+
+#include "smack/InlineLeafFunctions.h"
+#include "smack/Debug.h"
+#include "smack/Naming.h"
+#include "smack/SmackOptions.h"
+#include "smack/SmackWarnings.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <string>
+#include <vector>
+
+#define DEBUG_TYPE "smack-inline-leaves"
+
+namespace smack {
+
+using namespace llvm;
+
+namespace {
+// Conditional branches double the paths through the body, and memory accesses
+// select from or update the memory maps.
+const unsigned BRANCH_COST = 4;
+const unsigned MEMORY_COST = 2;
+
+// Returns true if calls to the named function are translated with respect to
+// the procedure they appear in.
+bool isProcedureScoped(StringRef name) {
+  return name == Naming::DECL_PROC || name == Naming::TOP_DECL_PROC ||
+         name == Naming::MOD_PROC || name == Naming::RETURN_VALUE_PROC ||
+         name.startswith("__CONTRACT");
+}
+
+// Returns true if calls to the named function are translated depending on
+// whether the procedure they appear in is checked.
+bool isCheckScoped(StringRef name) {
+  return name == "__VERIFIER_assert" || name == "llvm.assume" ||
+         name == Naming::RUST_PANIC_MARKER;
+}
+
+// Returns true if the named function must keep its own procedure.
+bool isSpecial(StringRef name) {
+  return name == "__VERIFIER_assert" || name.startswith("__VERIFIER_atomic") ||
+         name.startswith("__CONTRACT") ||
+         name.startswith(Naming::INIT_FUNC_PREFIX) ||
+         name == Naming::STATIC_INIT_PROC ||
+         name == Naming::DECLARATIONS_PROC ||
+         SmackOptions::isEntryPoint(name) ||
+         (!SmackOptions::CheckedFunctions.empty() &&
+          SmackOptions::shouldCheckFunction(name));
+}
+
+Function *getCallee(CallBase *CB) {
+  return dyn_cast<Function>(CB->getCalledOperand()->stripPointerCasts());
+}
+} // namespace
+
+unsigned InlineLeafFunctions::getCost(Function &F) {
+  auto &DL = F.getParent()->getDataLayout();
+  unsigned cost = 0;
+  for (auto &I : instructions(F)) {
+    if (isa<DbgInfoIntrinsic>(I) || isa<ReturnInst>(I) ||
+        isa<UnreachableInst>(I))
+      continue;
+
+    if (auto BI = dyn_cast<BranchInst>(&I)) {
+      if (BI->isConditional())
+        cost += BRANCH_COST;
+    } else if (auto PN = dyn_cast<PHINode>(&I))
+      cost += PN->getNumIncomingValues();
+    else if (I.mayReadOrWriteMemory())
+      cost += MEMORY_COST;
+    else if (auto CI = dyn_cast<CastInst>(&I))
+      cost += !CI->isNoopCast(DL);
+    else
+      cost += 1;
+  }
+  return cost;
+}
+
+bool InlineLeafFunctions::isInlinable(Function &F) {
+  if (F.isDeclaration() || F.isVarArg() || isSpecial(F.getName()))
+    return false;
+
+  SmallVector<std::pair<const BasicBlock *, const BasicBlock *>, 8> backedges;
+  FindFunctionBackedges(F, backedges);
+  if (!backedges.empty())
+    return false;
+
+  for (auto &I : instructions(F)) {
+    if (auto CB = dyn_cast<CallBase>(&I)) {
+      auto G = getCallee(CB);
+      if (!isa<CallInst>(CB) || !G || !G->isDeclaration() ||
+          isProcedureScoped(G->getName()))
+        return false;
+    }
+  }
+
+  unsigned frame = F.arg_size() + !F.getReturnType()->isVoidTy() + 1;
+  unsigned cost = getCost(F);
+  SDEBUG(errs() << "leaf " << F.getName() << " costs " << cost << "\n");
+  return cost <= SmackOptions::InlineLeafThreshold + frame;
+}
+
+bool InlineLeafFunctions::canInline(CallInst &CI) {
+  auto F = CI.getCalledFunction();
+  if (!F || !leaves.count(F))
+    return false;
+
+  // Leaves are not checked; neither should their code be once inlined.
+  if (SmackOptions::CheckedFunctions.empty() ||
+      !SmackOptions::shouldCheckFunction(CI.getFunction()->getName()))
+    return true;
+
+  for (auto &I : instructions(F))
+    if (auto CB = dyn_cast<CallBase>(&I))
+      if (isCheckScoped(getCallee(CB)->getName()))
+        return false;
+  return true;
+}
+
+void InlineLeafFunctions::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<CallGraphWrapperPass>();
+}
+
+bool InlineLeafFunctions::runOnModule(Module &M) {
+  auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+
+  // Callees come before their callers, and recursive functions are skipped.
+  std::vector<Function *> order;
+  for (auto I = scc_begin(&CG); !I.isAtEnd(); ++I)
+    if (!I.hasCycle())
+      if (auto F = (*I).front()->getFunction())
+        order.push_back(F);
+
+  bool changed = false;
+  for (auto F : order) {
+    std::vector<CallInst *> calls;
+    for (auto &I : instructions(F))
+      if (auto CI = dyn_cast<CallInst>(&I))
+        if (canInline(*CI))
+          calls.push_back(CI);
+
+    for (auto CI : calls) {
+      InlineFunctionInfo IFI;
+      if (InlineFunction(*CI, IFI).isSuccess()) {
+        ++numInlined;
+        changed = true;
+      }
+    }
+
+    if (isInlinable(*F))
+      leaves.insert(F);
+  }
+
+  SmackWarnings::warnInfo("inlined " + std::to_string(numInlined) +
+                          " calls to leaf functions");
+  return changed;
+}
+
+// Pass ID variable
+char InlineLeafFunctions::ID = 0;
+
+StringRef InlineLeafFunctions::getPassName() const {
+  return "Inline leaf functions";
+}
+} // namespace smack
@@ -91,6 +91,24 @@ Value *IntegerOverflowChecker::createResult(Value *v, int bits,
       v, IntegerType::get(i->getFunction()->getContext(), bits), "", i);
 }
 
+/*
+ * Generates a call to the overflow predicate of the checked operation, e.g.,
+ * __SMACK_overflow.smul.i64, which the translator emits as the bit-vector
+ * prelude function $smul.ovf.bv64. This avoids the double-width arithmetic
+ * used in the integer encoding, which is expensive to bit-blast.
+ */
+Value *IntegerOverflowChecker::createPredicate(std::string op, int bits,
+                                               bool isSigned, CallInst *ci) {
+  auto &C = ci->getContext();
+  auto T = IntegerType::get(C, bits);
+  std::string name = Naming::OVERFLOW_PREDICATE + "." +
+                     (isSigned ? "s" : "u") + op + ".i" + std::to_string(bits);
+  auto F = ci->getModule()->getOrInsertFunction(
+      name, FunctionType::get(Type::getInt1Ty(C), {T, T}, false));
+  return CallInst::Create(F, {ci->getArgOperand(0), ci->getArgOperand(1)}, "",
+                          ci);
+}
+
 /*
  * This adds a call instruction to __SMACK_check_overflow to determine if an
  * overflow occured as indicated by flag.
@@ -151,9 +169,11 @@ bool IntegerOverflowChecker::runOnModule(Module &m) {
              * checked value intrinsic f, then we do the following:
              * - The intrinsic is replaced with the non-intrinsic version of the
              *   operation.
-             * - If checking is enabled, the operation is computed in double bit
-             *   width.
-             * - A flag is computed to determine whether an overflow occured.
+             * - In the integer encoding, the operation is computed in double
+             *   bit width and a flag is computed to determine whether an
+             *   overflow occured.
+             * - In the bit-vector encoding, the flag is instead computed by a
+             *   call to a native overflow predicate.
              * - The overflow flag is optionally checked to raise an
              *   integer-overflow assertion violation.
              * - Finally, an assumption about the value of the flag is created
@@ -166,17 +186,25 @@ bool IntegerOverflowChecker::runOnModule(Module &m) {
             unsigned bits = 0;
             auto res = info[3].getAsInteger(10, bits);
             assert(!res && "Invalid bit widths.");
-            Value *eo1 =
-                extendBitWidth(ci->getArgOperand(0), bits, isSigned, ci);
-            Value *eo2 =
-                extendBitWidth(ci->getArgOperand(1), bits, isSigned, ci);
             SDEBUG(errs() << "Processing operator: " << op << "\n");
             assert(INSTRUCTION_TABLE.count(op) != 0 &&
                    "Operator must be present in our instruction table.");
-            BinaryOperator *ai = BinaryOperator::Create(
-                INSTRUCTION_TABLE.at(op), eo1, eo2, "", ci);
-            Value *r = createResult(ai, bits, &*I);
-            BinaryOperator *flag = createFlag(ai, bits, isSigned, ci);
+            Value *r, *flag;
+            if (SmackOptions::BitPrecise) {
+              r = BinaryOperator::Create(INSTRUCTION_TABLE.at(op),
+                                         ci->getArgOperand(0),
+                                         ci->getArgOperand(1), "", ci);
+              flag = createPredicate(op, bits, isSigned, ci);
+            } else {
+              Value *eo1 =
+                  extendBitWidth(ci->getArgOperand(0), bits, isSigned, ci);
+              Value *eo2 =
+                  extendBitWidth(ci->getArgOperand(1), bits, isSigned, ci);
+              BinaryOperator *ai = BinaryOperator::Create(
+                  INSTRUCTION_TABLE.at(op), eo1, eo2, "", ci);
+              r = createResult(ai, bits, &*I);
+              flag = createFlag(ai, bits, isSigned, ci);
+            }
             if (SmackOptions::IntegerOverflow &&
                 SmackOptions::shouldCheckFunction(F.getName()))
               addCheck(co, flag, ci);
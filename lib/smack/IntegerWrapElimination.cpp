@@ -0,0 +1,249 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+
+//
+// This pass finds the wrap operations ($tos/$tou) of the wrapped-integer
+// encoding which are identities. The encoding keeps integer values unbounded
+// through arithmetic and only wraps them where the result depends on the
+// representative: comparisons, division, and casts. A wrap is redundant when
+// its operand is already in range, e.g., a loop counter which is incremented
+// without overflow and compared against a bound. Such instructions are marked
+// with metadata, and translated without wraps by SmackRep.
+//
+// For each integer value, the pass infers whether its representative is in
+// the signed range, the unsigned range, or both, as the greatest fixpoint of
+// the transfer functions below, using the nsw/nuw flags and ranges computed by
+// LazyValueInfo and ScalarEvolution.
+//
+
+#define DEBUG_TYPE "smack-wrap-elimination"
+#include "smack/IntegerWrapElimination.h"
+#include "smack/Debug.h"
+#include "smack/Naming.h"
+#include "smack/SmackRep.h"
+#include "smack/SmackWarnings.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/IR/ConstantRange.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InstIterator.h"
+#include <string>
+
+namespace smack {
+
+using namespace llvm;
+
+namespace {
+const std::string WRAP_FREE = "smack-wrap-free";
+
+void mark(Instruction &I) {
+  I.setMetadata(WRAP_FREE, MDNode::get(I.getContext(), {}));
+}
+
+// Returns true if the translation of I wraps its operands.
+bool hasWrap(const Instruction *I) {
+  switch (I->getOpcode()) {
+  case Instruction::UDiv:
+  case Instruction::URem:
+  case Instruction::SDiv:
+  case Instruction::Trunc:
+  case Instruction::ZExt:
+  case Instruction::SExt:
+    return I->getType()->isIntegerTy();
+  case Instruction::ICmp:
+    return I->getOperand(0)->getType()->isIntegerTy();
+  default:
+    return false;
+  }
+}
+} // namespace
+
+void IntegerWrapElimination::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+  AU.addRequired<LazyValueInfoWrapperPass>();
+  AU.addRequired<ScalarEvolutionWrapperPass>();
+}
+
+// The representative of a constant depends on the context it is used in,
+// as chosen by SmackRep::lit.
+unsigned IntegerWrapElimination::getFacts(const Value *V, bool isUnsigned,
+                                          bool isUnsignedInst) {
+  if (auto CI = dyn_cast<ConstantInt>(V)) {
+    if (SmackRep::isNegativeLit(CI, isUnsigned, isUnsignedInst))
+      return SIGNED;
+    return CI->isNegative() ? UNSIGNED : SIGNED | UNSIGNED;
+  }
+  auto F = facts.find(V);
+  return F != facts.end() ? F->second : 0;
+}
+
+// The facts of the operand are refined by its range at I, e.g., a loop
+// counter is known to be non-negative below the loop condition.
+unsigned IntegerWrapElimination::getFacts(Instruction *I, unsigned opIdx) {
+  auto flags = SmackRep::litFlags(I);
+  auto V = I->getOperand(opIdx);
+  auto f = getFacts(V, flags.first, flags.second);
+  if (isa<Constant>(V) || !V->getType()->isIntegerTy())
+    return f;
+  return getRangeFacts(V, I, f);
+}
+
+// A value in either range whose sign bit is clear is in both ranges. The
+// ranges of LazyValueInfo hold at I, and those of ScalarEvolution bound the
+// induction variables of loops.
+unsigned IntegerWrapElimination::getRangeFacts(Value *V, Instruction *I,
+                                               unsigned f) {
+  auto &LVI = getAnalysis<LazyValueInfoWrapperPass>().getLVI();
+  auto &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+  if (f && (LVI.getConstantRange(V, I, false).getSignedMin().isNonNegative() ||
+            SE.isKnownNonNegative(SE.getSCEV(V))))
+    return SIGNED | UNSIGNED;
+  return f;
+}
+
+// Returns true if the arithmetic operation I can not overflow the signed
+// (resp. unsigned) range, according to the ranges of its operands.
+bool IntegerWrapElimination::fits(Instruction *I, bool isSigned) {
+  auto &LVI = getAnalysis<LazyValueInfoWrapperPass>().getLVI();
+  unsigned width = I->getType()->getIntegerBitWidth();
+  auto extend = [&](Value *V) {
+    auto R = LVI.getConstantRange(V, I, false);
+    return isSigned ? R.signExtend(2 * width + 1)
+                    : R.zeroExtend(2 * width + 1);
+  };
+  auto result = extend(I->getOperand(0))
+                    .binaryOp(static_cast<Instruction::BinaryOps>(
+                                  I->getOpcode()),
+                              extend(I->getOperand(1)));
+  return isSigned ? result.getMinSignedBits() <= width
+                  : result.getActiveBits() <= width;
+}
+
+bool IntegerWrapElimination::isWrapFree(Instruction *I) {
+  auto &LVI = getAnalysis<LazyValueInfoWrapperPass>().getLVI();
+  switch (I->getOpcode()) {
+  case Instruction::UDiv:
+  case Instruction::URem:
+    return getFacts(I, 0) & getFacts(I, 1) & UNSIGNED;
+  case Instruction::SDiv:
+    return getFacts(I, 0) & getFacts(I, 1) & SIGNED;
+  case Instruction::ICmp: {
+    auto both = getFacts(I, 0) & getFacts(I, 1);
+    auto P = cast<ICmpInst>(I);
+    if (P->isEquality())
+      return both;
+    return both & (P->isUnsigned() ? UNSIGNED : SIGNED);
+  }
+  case Instruction::Trunc:
+    return (getFacts(I, 0) & UNSIGNED) &&
+           LVI.getConstantRange(I->getOperand(0), I, false).getActiveBits() <=
+               I->getType()->getIntegerBitWidth();
+  case Instruction::ZExt:
+    return getFacts(I, 0) & UNSIGNED;
+  case Instruction::SExt:
+    return getFacts(I, 0) & SIGNED;
+  default:
+    return false;
+  }
+}
+
+// Returns the ranges which the representative of I is known to be in. These
+// hold whether or not the wraps of I are eliminated.
+unsigned IntegerWrapElimination::transfer(Instruction *I) {
+  unsigned f = 0;
+  switch (I->getOpcode()) {
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::Mul: {
+    auto both = getFacts(I, 0) & getFacts(I, 1);
+    if ((both & SIGNED) && (I->hasNoSignedWrap() || fits(I, true)))
+      f |= SIGNED;
+    if ((both & UNSIGNED) && (I->hasNoUnsignedWrap() || fits(I, false)))
+      f |= UNSIGNED;
+    break;
+  }
+  case Instruction::UDiv:
+  case Instruction::URem:
+  case Instruction::Trunc:
+  case Instruction::ICmp:
+    f = UNSIGNED;
+    break;
+  case Instruction::SDiv:
+  case Instruction::SRem:
+  case Instruction::SExt:
+    f = SIGNED;
+    break;
+  case Instruction::ZExt:
+    f = SIGNED | UNSIGNED;
+    break;
+  case Instruction::PHI:
+    f = SIGNED | UNSIGNED;
+    for (unsigned i = 0; i < I->getNumOperands(); ++i)
+      f &= getFacts(I, i);
+    break;
+  case Instruction::Select:
+    f = getFacts(I, 1) & getFacts(I, 2);
+    break;
+  default:
+    break;
+  }
+  return getRangeFacts(I, I, f);
+}
+
+bool IntegerWrapElimination::runOnFunction(Function &F) {
+  if (Naming::isSmackName(F.getName()))
+    return false;
+
+  facts.clear();
+  for (auto &I : instructions(F))
+    if (I.getType()->isIntegerTy())
+      facts[&I] = SIGNED | UNSIGNED;
+
+  bool changed;
+  do {
+    changed = false;
+    for (auto &I : instructions(F)) {
+      if (!I.getType()->isIntegerTy())
+        continue;
+      auto f = transfer(&I);
+      if (f != facts[&I]) {
+        facts[&I] = f;
+        changed = true;
+      }
+    }
+  } while (changed);
+
+  bool modified = false;
+  for (auto &I : instructions(F)) {
+    if (!hasWrap(&I))
+      continue;
+    numWraps++;
+    if (isWrapFree(&I)) {
+      SDEBUG(errs() << "Eliminating wraps of " << I << "\n");
+      mark(I);
+      numEliminated++;
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+bool IntegerWrapElimination::doFinalization(Module &M) {
+  SmackWarnings::warnInfo("eliminated wraps of " +
+                          std::to_string(numEliminated) + " of " +
+                          std::to_string(numWraps) + " integer operations");
+  return false;
+}
+
+bool IntegerWrapElimination::isMarked(const Instruction &I) {
+  return I.getMetadata(WRAP_FREE) != nullptr;
+}
+
+// Pass ID variable
+char IntegerWrapElimination::ID = 0;
+
+StringRef IntegerWrapElimination::getPassName() const {
+  return "Integer wrap elimination";
+}
+} // namespace smack
@@ -0,0 +1,556 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+
+//
+// This pass performs lazy sequentialization of pthread programs. It produces
+// a sequential program which simulates the interleavings of the threads
+// within a bounded number of scheduling rounds, and which can thus be checked
+// by any of the back-end verifiers.
+//
+// The function main is replaced by a scheduler which, in each round, runs
+// each active thread in order of creation. A thread is resumed where it was
+// suspended in the previous round, and may be suspended before each access to
+// a memory region which is shared with other threads, as identified by
+// Regions, and before each call into the pthread model. On suspension, the
+// thread records its program counter, which is dispatched on when it is
+// resumed in the next round.
+//
+// Thread functions, i.e., main and the start routines passed to
+// pthread_create, are cloned and their callees are inlined, so that all
+// suspension points are in the body of the clone. Their local variables are
+// moved into global arrays indexed by thread ID, so that they survive
+// suspension. The thread state itself is kept by the pthread model in
+// share/smack/lib/pthread.c when compiled with SMACK_SEQUENTIALIZE.
+//
+
+#include "smack/LazySequentialization.h"
+#include "smack/Debug.h"
+#include "smack/Naming.h"
+#include "smack/Regions.h"
+#include "smack/SmackOptions.h"
+#include "smack/SmackWarnings.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include <algorithm>
+#include <map>
+#include <string>
+
+#define DEBUG_TYPE "smack-lazy-seq"
+
+namespace smack {
+
+using namespace llvm;
+
+namespace {
+const std::string CONTEXT_SWITCH = "smack-context-switch";
+const std::string CONTEXT_SWITCH_PROC = "__SMACK_context_switch";
+
+void mark(Instruction &I) {
+  I.setMetadata(CONTEXT_SWITCH, MDNode::get(I.getContext(), {}));
+}
+
+bool isMarked(const Instruction &I) { return I.getMetadata(CONTEXT_SWITCH); }
+
+Function *getCallee(const Instruction &I) {
+  if (auto CI = dyn_cast<CallInst>(&I))
+    return CI->getCalledFunction();
+  return nullptr;
+}
+
+bool isCallTo(const Instruction &I, StringRef name) {
+  auto F = getCallee(I);
+  return F && F->getName() == name;
+}
+
+// Returns true if I is a call into the pthread model.
+bool isPthreadCall(const Instruction &I) {
+  auto F = getCallee(I);
+  return F && F->getName().startswith("pthread_");
+}
+
+// Returns the pointers to the memory accessed by I.
+std::vector<Value *> getAccessedPointers(Instruction &I) {
+  if (auto LI = dyn_cast<LoadInst>(&I))
+    return {LI->getPointerOperand()};
+  if (auto SI = dyn_cast<StoreInst>(&I))
+    return {SI->getPointerOperand()};
+  if (auto AI = dyn_cast<AtomicRMWInst>(&I))
+    return {AI->getPointerOperand()};
+  if (auto AI = dyn_cast<AtomicCmpXchgInst>(&I))
+    return {AI->getPointerOperand()};
+  if (auto MI = dyn_cast<MemTransferInst>(&I))
+    return {MI->getRawDest(), MI->getRawSource()};
+  if (auto MI = dyn_cast<MemSetInst>(&I))
+    return {MI->getRawDest()};
+  return {};
+}
+
+// Returns true if P points into a stack allocation whose address does not
+// escape, and which thus cannot be accessed by other threads.
+bool isThreadLocal(const Value *P) {
+  auto O = getUnderlyingObject(P);
+  return isa<AllocaInst>(O) && !PointerMayBeCaptured(O, true, true);
+}
+
+ReturnInst *createReturn(Function *F, BasicBlock *BB) {
+  auto T = F->getReturnType();
+  return ReturnInst::Create(F->getContext(),
+                            T->isVoidTy() ? nullptr : UndefValue::get(T), BB);
+}
+} // namespace
+
+GlobalVariable *LazySequentialization::getThreadGlobal(StringRef name) {
+  auto G = M->getGlobalVariable(name);
+  assert(G && "Expected the pthread model compiled with SMACK_SEQUENTIALIZE.");
+  return G;
+}
+
+Value *LazySequentialization::getCurrentThread(IRBuilder<> &B) {
+  return B.CreateLoad(B.getInt32Ty(),
+                      getThreadGlobal("__SMACK_current_thread"));
+}
+
+Value *LazySequentialization::getThreadSlot(IRBuilder<> &B, StringRef name,
+                                            Value *tid) {
+  auto G = getThreadGlobal(name);
+  return B.CreateInBoundsGEP(G->getValueType(), G, {B.getInt32(0), tid});
+}
+
+// Library functions are not inlined, and execute atomically.
+bool LazySequentialization::isLibrary(const Function *F) {
+  auto name = F->getName();
+  return name.startswith("pthread_") || name.startswith("__VERIFIER_") ||
+         Naming::isSmackName(name);
+}
+
+// Returns the non-library functions reachable from roots by direct calls.
+std::set<Function *>
+LazySequentialization::reachable(std::vector<Function *> roots) {
+  std::set<Function *> fs;
+  while (!roots.empty()) {
+    auto F = roots.back();
+    roots.pop_back();
+    if (F->isDeclaration() || isLibrary(F) || !fs.insert(F).second)
+      continue;
+    for (auto &I : instructions(F))
+      if (auto G = getCallee(I))
+        roots.push_back(G);
+  }
+  return fs;
+}
+
+// Marks the context-switch points of the code executed by threads: calls
+// into the pthread model, and accesses to regions which are also accessed by
+// code executed by started threads. Since a start routine may be run by
+// several threads, each of its accesses to a region is potentially shared,
+// unless it is to a stack allocation which does not escape, or to a region
+// which the thread-escape analysis of DSAWrapper finds thread local.
+void LazySequentialization::markContextSwitches(
+    std::vector<Function *> threads, std::vector<Function *> routines) {
+  auto &R = getAnalysis<Regions>();
+  std::set<unsigned> shared;
+
+  for (auto F : reachable(routines))
+    for (auto &I : instructions(F))
+      for (auto P : getAccessedPointers(I))
+        if (!isThreadLocal(P) && !R.get(R.idx(P)).isThreadLocal())
+          shared.insert(R.idx(P));
+
+  for (auto F : reachable(threads))
+    for (auto &I : instructions(F)) {
+      if (isPthreadCall(I))
+        mark(I);
+      for (auto P : getAccessedPointers(I))
+        if (!isThreadLocal(P) && shared.count(R.idx(P)))
+          mark(I);
+    }
+}
+
+// Inlines the non-library callees of F, so that threads are only suspended
+// within F itself. Calls to recursive functions execute atomically.
+void LazySequentialization::inlineCalls(Function *F) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    std::vector<CallBase *> calls;
+    for (auto &I : instructions(F))
+      if (auto CB = dyn_cast<CallBase>(&I))
+        if (auto G = CB->getCalledFunction())
+          if (!G->isDeclaration() && !isLibrary(G) && !recursive.count(G))
+            calls.push_back(CB);
+    for (auto CB : calls) {
+      InlineFunctionInfo IFI;
+      changed |= InlineFunction(*CB, IFI).isSuccess();
+    }
+  }
+}
+
+// The sequentialized pthread_cond_wait releases the mutex and returns, so
+// that another thread can be scheduled before the mutex is acquired again.
+void LazySequentialization::reacquireMutexes(Function *F) {
+  auto lock = M->getFunction("pthread_mutex_lock");
+  if (!lock)
+    return;
+
+  std::vector<CallInst *> waits;
+  for (auto &I : instructions(F))
+    if (isCallTo(I, "pthread_cond_wait"))
+      waits.push_back(cast<CallInst>(&I));
+
+  for (auto CI : waits) {
+    IRBuilder<> B(CI->getNextNode());
+    auto T = lock->getFunctionType()->getParamType(0);
+    mark(*B.CreateCall(lock, {B.CreatePointerCast(CI->getArgOperand(1), T)}));
+  }
+}
+
+// Records the return value of the thread at each return of F, and returns
+// from F after each call to pthread_exit.
+void LazySequentialization::splitReturns(Function *F) {
+  auto ret = M->getFunction("__SMACK_thread_return");
+  assert(ret &&
+         "Expected the pthread model compiled with SMACK_SEQUENTIALIZE.");
+  auto T = ret->getFunctionType()->getParamType(0);
+
+  std::vector<ReturnInst *> returns;
+  std::vector<CallInst *> exits;
+  for (auto &I : instructions(F)) {
+    if (auto RI = dyn_cast<ReturnInst>(&I))
+      returns.push_back(RI);
+    else if (isCallTo(I, "pthread_exit"))
+      exits.push_back(cast<CallInst>(&I));
+  }
+
+  for (auto RI : returns) {
+    IRBuilder<> B(RI);
+    auto V = RI->getReturnValue();
+    B.CreateCall(ret, {V && V->getType()->isPointerTy()
+                           ? B.CreatePointerCast(V, T)
+                           : Constant::getNullValue(T)});
+  }
+
+  for (auto CI : exits) {
+    auto BB = CI->getParent();
+    SplitBlock(BB, CI->getNextNode());
+    BB->getTerminator()->eraseFromParent();
+    createReturn(F, BB);
+  }
+}
+
+// Guards each context-switch point with a nondeterministic choice to suspend
+// the thread, and returns the blocks at which suspended threads resume.
+std::vector<BasicBlock *>
+LazySequentialization::splitContextSwitches(Function *F) {
+  auto &C = F->getContext();
+  auto cs = M->getOrInsertFunction(CONTEXT_SWITCH_PROC, Type::getInt1Ty(C));
+
+  std::vector<Instruction *> points;
+  for (auto &I : instructions(F))
+    if (isMarked(I))
+      points.push_back(&I);
+
+  std::vector<BasicBlock *> resumes;
+  for (auto I : points) {
+    auto guard = SplitBlock(I->getParent(), I);
+    auto body = SplitBlock(guard, I);
+    auto yield = BasicBlock::Create(C, "", F, body);
+    guard->getTerminator()->eraseFromParent();
+
+    IRBuilder<> B(guard);
+    B.CreateCondBr(B.CreateCall(cs), yield, body);
+    B.SetInsertPoint(yield);
+    B.CreateStore(
+        B.getInt32(resumes.size() + 1),
+        getThreadSlot(B, "__SMACK_thread_pc", getCurrentThread(B)));
+    createReturn(F, yield);
+    resumes.push_back(guard);
+  }
+  return resumes;
+}
+
+// Adds dispatches on the program counter of the thread, which is 0 at the
+// beginning of F. To keep loops reducible, a resumption point within a loop is
+// reached through the headers of the enclosing loops, each of which dispatches
+// to the next nesting level. The program counter is reset to 0 once the
+// resumption point is reached.
+void LazySequentialization::makeResumable(
+    Function *F, const std::vector<BasicBlock *> &resumes) {
+  auto &C = F->getContext();
+  DominatorTree DT(*F);
+  LoopInfo LI(DT);
+
+  std::vector<std::vector<BasicBlock *>> nests;
+  for (auto BB : resumes) {
+    std::vector<BasicBlock *> headers;
+    for (auto L = LI.getLoopFor(BB); L; L = L->getParentLoop())
+      headers.insert(headers.begin(), L->getHeader());
+    nests.push_back(headers);
+  }
+
+  auto entry = &F->getEntryBlock();
+  auto dispatch = BasicBlock::Create(C, "", F, entry);
+  IRBuilder<> B(dispatch);
+  auto pc = B.CreateLoad(
+      B.getInt32Ty(),
+      getThreadSlot(B, "__SMACK_thread_pc", getCurrentThread(B)));
+  std::map<BasicBlock *, SwitchInst *> switches;
+  switches[dispatch] = B.CreateSwitch(pc, entry);
+
+  // The dispatch of a loop header precedes its original code, and its phi
+  // nodes are demoted since the header is entered from the dispatch as well.
+  for (auto &headers : nests)
+    for (auto H : headers) {
+      if (switches.count(H))
+        continue;
+      std::vector<PHINode *> phis;
+      for (auto &P : H->phis())
+        phis.push_back(&P);
+      for (auto P : phis)
+        DemotePHIToStack(P, dispatch->getTerminator());
+      auto rest = SplitBlock(H, &*H->getFirstInsertionPt());
+      H->getTerminator()->eraseFromParent();
+      B.SetInsertPoint(H);
+      switches[H] = B.CreateSwitch(
+          B.CreateLoad(B.getInt32Ty(), getThreadSlot(B, "__SMACK_thread_pc",
+                                                     getCurrentThread(B))),
+          rest);
+    }
+
+  for (unsigned i = 0; i < resumes.size(); ++i) {
+    auto resume = BasicBlock::Create(C, "", F, resumes[i]);
+    B.SetInsertPoint(resume);
+    B.CreateStore(B.getInt32(0), getThreadSlot(B, "__SMACK_thread_pc",
+                                               getCurrentThread(B)));
+    B.CreateBr(resumes[i]);
+
+    auto from = dispatch;
+    for (auto H : nests[i]) {
+      switches[from]->addCase(B.getInt32(i + 1), H);
+      from = H;
+    }
+    switches[from]->addCase(B.getInt32(i + 1), resume);
+  }
+}
+
+// Demotes the registers whose definitions no longer dominate their uses,
+// since their uses are reachable from resumption points. Fixed-size stack
+// allocations are excluded, as they are moved to the entry block anyway.
+void LazySequentialization::demoteRegisters(Function *F) {
+  DominatorTree DT(*F);
+  std::vector<Instruction *> values;
+  for (auto &I : instructions(F)) {
+    auto AI = dyn_cast<AllocaInst>(&I);
+    if (AI && isa<ConstantInt>(AI->getArraySize()))
+      continue;
+    for (auto &U : I.uses())
+      if (!DT.dominates(&I, U)) {
+        values.push_back(&I);
+        break;
+      }
+  }
+
+  auto point = &*F->getEntryBlock().getFirstInsertionPt();
+  for (auto I : values)
+    DemoteRegToStack(*I, false, point);
+}
+
+// Moves the stack allocations of F into global arrays indexed by thread ID,
+// so that they survive the suspension of the thread.
+void LazySequentialization::privatizeLocals(Function *F) {
+  std::vector<AllocaInst *> allocas;
+  for (auto &I : instructions(F))
+    if (auto AI = dyn_cast<AllocaInst>(&I)) {
+      if (isa<ConstantInt>(AI->getArraySize()))
+        allocas.push_back(AI);
+      else
+        SmackWarnings::warnApproximate(
+            "variable-length stack allocation in a sequentialized thread",
+            nullptr, AI);
+    }
+
+  auto point = F->getEntryBlock().getFirstInsertionPt();
+  while (isa<AllocaInst>(point))
+    ++point;
+  IRBuilder<> B(&*point);
+  auto tid = getCurrentThread(B);
+  for (auto AI : allocas) {
+    Type *T = AI->getAllocatedType();
+    if (AI->isArrayAllocation())
+      T = ArrayType::get(
+          T, cast<ConstantInt>(AI->getArraySize())->getZExtValue());
+    auto AT = ArrayType::get(T, numThreads);
+    auto G = new GlobalVariable(*M, AT, false, GlobalValue::InternalLinkage,
+                                UndefValue::get(AT),
+                                F->getName() + "." + AI->getName());
+    G->setAlignment(AI->getAlign());
+    auto P = B.CreateInBoundsGEP(AT, G, {B.getInt32(0), tid});
+    AI->replaceAllUsesWith(B.CreatePointerCast(P, AI->getType()));
+    AI->eraseFromParent();
+  }
+}
+
+void LazySequentialization::sequentialize(Function *F) {
+  SDEBUG(errs() << "Sequentializing thread function " << F->getName()
+                << "\n");
+  inlineCalls(F);
+  reacquireMutexes(F);
+  splitReturns(F);
+  EliminateUnreachableBlocks(*F);
+  makeResumable(F, splitContextSwitches(F));
+  demoteRegisters(F);
+  privatizeLocals(F);
+}
+
+// Replaces the body of main by the scheduler. In each round, each active
+// thread is run until it is suspended or terminates; the program terminates
+// with the main thread.
+void LazySequentialization::createScheduler(
+    Function *main, Function *mainThread,
+    const std::vector<Function *> &routines,
+    const std::vector<Function *> &threads) {
+  auto &C = M->getContext();
+  main->deleteBody();
+
+  auto exit = BasicBlock::Create(C, "", main);
+  IRBuilder<> B(exit);
+  if (main->getReturnType()->isVoidTy())
+    B.CreateRetVoid();
+  else
+    B.CreateRet(Constant::getNullValue(main->getReturnType()));
+
+  // Each slot is created before its successor, so that the first slot of the
+  // first round is the entry block.
+  BasicBlock *next = exit;
+  for (unsigned r = SmackOptions::SequentializationRounds; r > 0; --r)
+    for (unsigned t = numThreads - 1; t > 0; --t) {
+      auto check = BasicBlock::Create(C, "", main, next);
+      auto run = BasicBlock::Create(C, "", main, next);
+      auto tid = B.getInt32(t);
+
+      B.SetInsertPoint(check);
+      auto active = B.CreateLoad(
+          B.getInt32Ty(), getThreadSlot(B, "__SMACK_thread_active", tid));
+      B.CreateCondBr(B.CreateICmpNE(active, B.getInt32(0)), run, next);
+
+      B.SetInsertPoint(run);
+      B.CreateStore(tid, getThreadGlobal("__SMACK_current_thread"));
+      if (t == 1) {
+        std::vector<Value *> args;
+        for (auto &A : main->args())
+          args.push_back(&A);
+        B.CreateCall(mainThread, args);
+        auto done = B.CreateLoad(
+            B.getInt32Ty(), getThreadSlot(B, "__SMACK_thread_done", tid));
+        B.CreateCondBr(B.CreateICmpNE(done, B.getInt32(0)), exit, next);
+
+      } else {
+        auto RP = getThreadSlot(B, "__SMACK_thread_routine", tid);
+        auto routine = B.CreateLoad(RP->getType()->getPointerElementType(), RP);
+        auto AP = getThreadSlot(B, "__SMACK_thread_arg", tid);
+        auto arg = B.CreateLoad(AP->getType()->getPointerElementType(), AP);
+        for (unsigned i = 0; i < routines.size(); ++i) {
+          auto call = BasicBlock::Create(C, "", main, next);
+          auto other = BasicBlock::Create(C, "", main, next);
+          B.CreateCondBr(
+              B.CreateICmpEQ(routine, B.CreatePointerCast(
+                                          routines[i], routine->getType())),
+              call, other);
+
+          B.SetInsertPoint(call);
+          std::vector<Value *> args;
+          if (!threads[i]->arg_empty())
+            args.push_back(
+                B.CreatePointerCast(arg, threads[i]->getArg(0)->getType()));
+          B.CreateCall(threads[i], args);
+          B.CreateBr(next);
+          B.SetInsertPoint(other);
+        }
+        B.CreateBr(next);
+      }
+      next = check;
+    }
+}
+
+bool LazySequentialization::runOnModule(Module &M) {
+  this->M = &M;
+  auto main = M.getFunction("main");
+  auto create = M.getFunction("pthread_create");
+  if (!main || main->isDeclaration() || !create)
+    return false;
+
+  numThreads =
+      cast<ArrayType>(getThreadGlobal("__SMACK_thread_pc")->getValueType())
+          ->getNumElements();
+
+  std::vector<Function *> routines;
+  for (auto U : create->users())
+    if (auto CI = dyn_cast<CallInst>(U)) {
+      auto R = dyn_cast<Function>(CI->getArgOperand(2)->stripPointerCasts());
+      if (R && !R->isDeclaration() && R->arg_size() <= 1 &&
+          (R->arg_empty() || R->getArg(0)->getType()->isPointerTy())) {
+        if (std::find(routines.begin(), routines.end(), R) == routines.end())
+          routines.push_back(R);
+      } else
+        SmackWarnings::warnApproximate("thread with unknown start routine",
+                                       nullptr, CI);
+    }
+
+  for (auto &F : M) {
+    if (F.isDeclaration())
+      continue;
+    std::vector<Function *> callees;
+    for (auto &I : instructions(F))
+      if (auto G = getCallee(I))
+        callees.push_back(G);
+    if (reachable(callees).count(&F))
+      recursive.insert(&F);
+  }
+
+  std::vector<Function *> roots(routines);
+  roots.push_back(main);
+  markContextSwitches(roots, routines);
+
+  auto clone = [](Function *F) {
+    ValueToValueMapTy VMap;
+    auto T = CloneFunction(F, VMap);
+    T->setName(F->getName() + ".thread");
+    T->setLinkage(GlobalValue::InternalLinkage);
+    return T;
+  };
+
+  auto mainThread = clone(main);
+  std::vector<Function *> threads;
+  for (auto R : routines)
+    threads.push_back(clone(R));
+
+  sequentialize(mainThread);
+  for (auto T : threads)
+    sequentialize(T);
+  createScheduler(main, mainThread, routines, threads);
+
+  for (auto &F : M)
+    for (auto &I : instructions(F))
+      I.setMetadata(CONTEXT_SWITCH, nullptr);
+
+  return true;
+}
+
+void LazySequentialization::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<Regions>();
+}
+
+// Pass ID variable
+char LazySequentialization::ID = 0;
+
+StringRef LazySequentialization::getPassName() const {
+  return "Lazy sequentialization of pthread programs";
+}
+} // namespace smack
@@ -0,0 +1,490 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+
+//
+// This pass infers invariants for the integer phi nodes of loop headers by
+// abstract interpretation, which SmackInstGenerator emits as free loop
+// invariants. Without them, loops can only be verified by bounded unrolling.
+//
+// The pass computes an interval for each integer value, over the unbounded
+// representatives of the integer encoding, refined by the conditions of the
+// branches dominating each use, with widening at loop headers followed by a
+// few narrowing iterations. In addition, it infers relations `i <= n` (resp.
+// `i >= n`) between an induction variable `i` and a loop-invariant bound `n`
+// of the branch which guards the back edge, conditional on the relation
+// holding on loop entry.
+//
+
+#include "smack/LoopInvariantInference.h"
+#include "smack/Debug.h"
+#include "smack/Naming.h"
+#include "smack/SmackOptions.h"
+#include "smack/SmackRep.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/Support/CheckedArithmetic.h"
+#include <algorithm>
+
+#define DEBUG_TYPE "smack-loop-invariants"
+
+namespace smack {
+
+using namespace llvm;
+
+namespace {
+const unsigned MAX_ITERATIONS = 100;
+const unsigned NARROWING_ITERATIONS = 2;
+
+// Returns the representative of C as translated by SmackRep::lit, if it fits
+// into 64 bits.
+Optional<int64_t> repValue(const ConstantInt *C, bool isUnsigned,
+                           bool isUnsignedInst) {
+  const APInt &V = C->getValue();
+  if (SmackRep::isNegativeLit(C, isUnsigned, isUnsignedInst)) {
+    if (V.getMinSignedBits() <= 64)
+      return V.getSExtValue();
+  } else if (V.getActiveBits() < 64) {
+    return (int64_t)V.getZExtValue();
+  }
+  return None;
+}
+
+using Interval = LoopInvariantInference::Interval;
+
+Interval top() {
+  Interval R;
+  R.empty = false;
+  return R;
+}
+
+Interval constant(int64_t v) {
+  auto R = top();
+  R.hasLower = R.hasUpper = true;
+  R.lower = R.upper = v;
+  return R;
+}
+
+void setLower(Interval &R, Optional<int64_t> v) {
+  if (R.empty || !v || (R.hasLower && R.lower >= *v))
+    return;
+  R.hasLower = true;
+  R.lower = *v;
+  R.empty = R.hasUpper && R.lower > R.upper;
+}
+
+void setUpper(Interval &R, Optional<int64_t> v) {
+  if (R.empty || !v || (R.hasUpper && R.upper <= *v))
+    return;
+  R.hasUpper = true;
+  R.upper = *v;
+  R.empty = R.hasLower && R.lower > R.upper;
+}
+
+bool operator==(const Interval &A, const Interval &B) {
+  if (A.empty || B.empty)
+    return A.empty == B.empty;
+  return A.hasLower == B.hasLower && A.hasUpper == B.hasUpper &&
+         (!A.hasLower || A.lower == B.lower) &&
+         (!A.hasUpper || A.upper == B.upper);
+}
+
+Interval join(Interval A, Interval B) {
+  if (A.empty)
+    return B;
+  if (B.empty)
+    return A;
+  auto R = top();
+  if (A.hasLower && B.hasLower)
+    setLower(R, std::min(A.lower, B.lower));
+  if (A.hasUpper && B.hasUpper)
+    setUpper(R, std::max(A.upper, B.upper));
+  return R;
+}
+
+// Drops the bounds of B which are not stable with respect to A.
+Interval widen(Interval A, Interval B) {
+  if (A.empty || B.empty)
+    return join(A, B);
+  auto R = top();
+  if (A.hasLower && B.hasLower && B.lower >= A.lower)
+    setLower(R, A.lower);
+  if (A.hasUpper && B.hasUpper && B.upper <= A.upper)
+    setUpper(R, A.upper);
+  return R;
+}
+
+Interval arith(unsigned opcode, Interval A, Interval B) {
+  if (A.empty || B.empty)
+    return A.empty ? A : B;
+  auto R = top();
+  switch (opcode) {
+  case Instruction::Add:
+    if (A.hasLower && B.hasLower)
+      setLower(R, checkedAdd(A.lower, B.lower));
+    if (A.hasUpper && B.hasUpper)
+      setUpper(R, checkedAdd(A.upper, B.upper));
+    break;
+  case Instruction::Sub:
+    if (A.hasLower && B.hasUpper)
+      setLower(R, checkedSub(A.lower, B.upper));
+    if (A.hasUpper && B.hasLower)
+      setUpper(R, checkedSub(A.upper, B.lower));
+    break;
+  case Instruction::Mul: {
+    if (!(A.hasLower && A.hasUpper && B.hasLower && B.hasUpper))
+      break;
+    std::vector<Optional<int64_t>> products{
+        checkedMul(A.lower, B.lower), checkedMul(A.lower, B.upper),
+        checkedMul(A.upper, B.lower), checkedMul(A.upper, B.upper)};
+    if (std::any_of(products.begin(), products.end(),
+                    [](Optional<int64_t> p) { return !p; }))
+      break;
+    std::vector<int64_t> values;
+    for (auto p : products)
+      values.push_back(*p);
+    setLower(R, *std::min_element(values.begin(), values.end()));
+    setUpper(R, *std::max_element(values.begin(), values.end()));
+    break;
+  }
+  default:
+    break;
+  }
+  return R;
+}
+} // namespace
+
+void LoopInvariantInference::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+  AU.addRequired<DominatorTreeWrapperPass>();
+  AU.addRequired<LoopInfoWrapperPass>();
+}
+
+// Returns the interval of V at the end of B, where constants are translated
+// with the given flags.
+LoopInvariantInference::Interval
+LoopInvariantInference::getInterval(const Value *V, const BasicBlock *B,
+                                    bool isUnsigned, bool isUnsignedInst) {
+  if (auto C = dyn_cast<ConstantInt>(V)) {
+    auto v = repValue(C, isUnsigned, isUnsignedInst);
+    return v ? constant(*v) : top();
+  }
+  auto I = intervals.find(V);
+  auto R = I != intervals.end() ? I->second : top();
+  for (auto N = DT->getNode(B); N && N->getIDom(); N = N->getIDom()) {
+    auto S = N->getBlock();
+    if (auto P = S->getSinglePredecessor())
+      R = refine(V, R, P, S);
+  }
+  return R;
+}
+
+// Returns the interval of the operand V of I.
+LoopInvariantInference::Interval
+LoopInvariantInference::getInterval(const Value *V, const Instruction *I) {
+  auto flags = SmackRep::litFlags(I);
+  return getInterval(V, I->getParent(), flags.first, flags.second);
+}
+
+// Refines the interval R of V by the condition of the edge from P to S.
+LoopInvariantInference::Interval
+LoopInvariantInference::refine(const Value *V, Interval R, const BasicBlock *P,
+                               const BasicBlock *S) {
+  auto BI = dyn_cast<BranchInst>(P->getTerminator());
+  if (R.empty || !BI || !BI->isConditional() ||
+      BI->getSuccessor(0) == BI->getSuccessor(1))
+    return R;
+  auto C = dyn_cast<ICmpInst>(BI->getCondition());
+  if (!C)
+    return R;
+  auto pred = BI->getSuccessor(0) == S ? C->getPredicate()
+                                       : C->getInversePredicate();
+  const Value *W;
+  if (C->getOperand(0) == V)
+    W = C->getOperand(1);
+  else if (C->getOperand(1) == V) {
+    W = C->getOperand(0);
+    pred = CmpInst::getSwappedPredicate(pred);
+  } else
+    return R;
+
+  // The integer encoding compares representatives regardless of signedness.
+  auto B = getInterval(W, P, C->isUnsigned(), true);
+  if (B.empty)
+    return R;
+  switch (pred) {
+  case CmpInst::ICMP_ULT:
+  case CmpInst::ICMP_SLT:
+    if (B.hasUpper)
+      setUpper(R, checkedSub(B.upper, (int64_t)1));
+    break;
+  case CmpInst::ICMP_ULE:
+  case CmpInst::ICMP_SLE:
+    if (B.hasUpper)
+      setUpper(R, B.upper);
+    break;
+  case CmpInst::ICMP_UGT:
+  case CmpInst::ICMP_SGT:
+    if (B.hasLower)
+      setLower(R, checkedAdd(B.lower, (int64_t)1));
+    break;
+  case CmpInst::ICMP_UGE:
+  case CmpInst::ICMP_SGE:
+    if (B.hasLower)
+      setLower(R, B.lower);
+    break;
+  case CmpInst::ICMP_EQ:
+    if (B.hasLower)
+      setLower(R, B.lower);
+    if (B.hasUpper)
+      setUpper(R, B.upper);
+    break;
+  case CmpInst::ICMP_NE:
+    if (B.hasLower && B.hasUpper && B.lower == B.upper) {
+      if (R.hasLower && R.lower == B.lower)
+        setLower(R, checkedAdd(R.lower, (int64_t)1));
+      if (R.hasUpper && R.upper == B.upper)
+        setUpper(R, checkedSub(R.upper, (int64_t)1));
+    }
+    break;
+  default:
+    break;
+  }
+  return R;
+}
+
+LoopInvariantInference::Interval
+LoopInvariantInference::transfer(const Instruction *I) {
+  switch (I->getOpcode()) {
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::Mul:
+    return arith(I->getOpcode(), getInterval(I->getOperand(0), I),
+                 getInterval(I->getOperand(1), I));
+  case Instruction::URem: {
+    // the Euclidean modulus is nonnegative
+    auto R = top();
+    auto B = getInterval(I->getOperand(1), I);
+    if (!B.empty && B.hasLower && B.lower > 0 && B.hasUpper) {
+      setLower(R, 0);
+      setUpper(R, B.upper - 1);
+    }
+    return R;
+  }
+  case Instruction::Trunc:
+  case Instruction::ZExt:
+  case Instruction::SExt:
+    // conversions are identities on the unbounded representatives
+    return getInterval(I->getOperand(0), I);
+  case Instruction::ICmp: {
+    auto R = top();
+    setLower(R, 0);
+    setUpper(R, 1);
+    return R;
+  }
+  case Instruction::Select:
+    return join(getInterval(I->getOperand(1), I),
+                getInterval(I->getOperand(2), I));
+  case Instruction::PHI: {
+    auto phi = cast<PHINode>(I);
+    auto flags = SmackRep::litFlags(I);
+    Interval R;
+    for (unsigned i = 0; i < phi->getNumIncomingValues(); ++i) {
+      auto P = phi->getIncomingBlock(i);
+      R = join(R, refine(phi->getIncomingValue(i),
+                         getInterval(phi->getIncomingValue(i), P, flags.first,
+                                     flags.second),
+                         P, phi->getParent()));
+    }
+    return R;
+  }
+  default:
+    return top();
+  }
+}
+
+// Computes the intervals of the integer values of F, returning false if the
+// computation does not converge, e.g., for irreducible control flow.
+bool LoopInvariantInference::inferIntervals(Function &F) {
+  auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+
+  intervals.clear();
+  for (auto B : RPOT)
+    for (auto &I : *B)
+      if (I.getType()->isIntegerTy())
+        intervals[&I] = Interval();
+
+  bool changed;
+  unsigned iterations = 0;
+  do {
+    if (++iterations > MAX_ITERATIONS)
+      return false;
+    changed = false;
+    for (auto B : RPOT) {
+      for (auto &I : *B) {
+        if (!I.getType()->isIntegerTy())
+          continue;
+        auto R = transfer(&I);
+        auto &old = intervals[&I];
+        if (isa<PHINode>(I) && LI.isLoopHeader(B))
+          R = widen(old, join(old, R));
+        if (!(R == old)) {
+          old = R;
+          changed = true;
+        }
+      }
+    }
+  } while (changed);
+
+  for (unsigned i = 0; i < NARROWING_ITERATIONS; ++i)
+    for (auto B : RPOT)
+      for (auto &I : *B)
+        if (I.getType()->isIntegerTy())
+          intervals[&I] = transfer(&I);
+  return true;
+}
+
+// Infers the relations between the induction variables of L and the
+// loop-invariant bounds of the conditions guarding its back edge.
+void LoopInvariantInference::inferRelations(const Loop *L) {
+  auto H = L->getHeader();
+  auto latch = L->getLoopLatch();
+  auto preheader = L->getLoopPreheader();
+  if (!latch || !preheader)
+    return;
+
+  // the edges which the back edge is control dependent on
+  std::vector<std::pair<const BasicBlock *, const BasicBlock *>> edges{
+      {latch, H}};
+  for (auto N = DT->getNode(latch); N && N->getBlock() != H;
+       N = N->getIDom())
+    if (auto P = N->getBlock()->getSinglePredecessor())
+      edges.emplace_back(P, N->getBlock());
+
+  for (auto &phi : H->phis()) {
+    if (!phi.getType()->isIntegerTy() || phi.getNumIncomingValues() != 2)
+      continue;
+    auto init = phi.getIncomingValueForBlock(preheader);
+    auto next = dyn_cast<BinaryOperator>(phi.getIncomingValueForBlock(latch));
+    Optional<int64_t> step;
+    if (next && next->getOperand(0) == &phi &&
+        (next->getOpcode() == Instruction::Add ||
+         next->getOpcode() == Instruction::Sub))
+      if (auto C = dyn_cast<ConstantInt>(next->getOperand(1))) {
+        auto flags = SmackRep::litFlags(next);
+        step = repValue(C, flags.first, flags.second);
+        if (step && next->getOpcode() == Instruction::Sub)
+          step = -*step;
+      }
+
+    for (auto &E : edges) {
+      auto BI = dyn_cast<BranchInst>(E.first->getTerminator());
+      if (!BI || !BI->isConditional() ||
+          BI->getSuccessor(0) == BI->getSuccessor(1))
+        continue;
+      auto C = dyn_cast<ICmpInst>(BI->getCondition());
+      if (!C)
+        continue;
+      auto pred = BI->getSuccessor(0) == E.second ? C->getPredicate()
+                                                  : C->getInversePredicate();
+      const Value *X = C->getOperand(0);
+      const Value *N = C->getOperand(1);
+      if (L->isLoopInvariant(X)) {
+        std::swap(X, N);
+        pred = CmpInst::getSwappedPredicate(pred);
+      }
+      if (isa<Constant>(N) || !L->isLoopInvariant(N))
+        continue;
+      if (ICmpInst::isUnsigned(pred))
+        pred = ICmpInst::getSignedPredicate(pred);
+
+      // phi = next is guarded by `next pred N` on the back edge
+      if (X == phi.getIncomingValueForBlock(latch)) {
+        switch (pred) {
+        case CmpInst::ICMP_SLT:
+          invariants[H].push_back({&phi, true, N, C->isUnsigned(), -1, init});
+          break;
+        case CmpInst::ICMP_SLE:
+          invariants[H].push_back({&phi, true, N, C->isUnsigned(), 0, init});
+          break;
+        case CmpInst::ICMP_SGT:
+          invariants[H].push_back({&phi, false, N, C->isUnsigned(), 1, init});
+          break;
+        case CmpInst::ICMP_SGE:
+          invariants[H].push_back({&phi, false, N, C->isUnsigned(), 0, init});
+          break;
+        default:
+          break;
+        }
+
+        // next = phi + step is guarded by `phi pred N` on the back edge
+      } else if (X == &phi && step && (*step == 1 || *step == -1)) {
+        bool upper = *step == 1;
+        if (upper && (pred == CmpInst::ICMP_SLT || pred == CmpInst::ICMP_NE))
+          invariants[H].push_back({&phi, true, N, C->isUnsigned(), 0, init});
+        else if (!upper &&
+                 (pred == CmpInst::ICMP_SGT || pred == CmpInst::ICMP_NE))
+          invariants[H].push_back({&phi, false, N, C->isUnsigned(), 0, init});
+        else if (upper && pred == CmpInst::ICMP_SLE)
+          invariants[H].push_back({&phi, true, N, C->isUnsigned(), 1, init});
+        else if (!upper && pred == CmpInst::ICMP_SGE)
+          invariants[H].push_back({&phi, false, N, C->isUnsigned(), -1, init});
+      }
+    }
+  }
+}
+
+bool LoopInvariantInference::runOnFunction(Function &F) {
+  invariants.clear();
+
+  // Intervals are computed over unbounded representatives, which the
+  // bit-vector and wrapped-integer encodings do not have.
+  if (Naming::isSmackName(F.getName()) || SmackOptions::BitPrecise ||
+      SmackOptions::WrappedIntegerEncoding)
+    return false;
+
+  DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+
+  if (inferIntervals(F)) {
+    for (auto &B : F) {
+      if (!LI.isLoopHeader(&B))
+        continue;
+      for (auto &phi : B.phis()) {
+        auto I = intervals.find(&phi);
+        if (I == intervals.end() || I->second.empty)
+          continue;
+        if (I->second.hasLower)
+          invariants[&B].push_back(
+              {&phi, false, nullptr, false, I->second.lower, nullptr});
+        if (I->second.hasUpper)
+          invariants[&B].push_back(
+              {&phi, true, nullptr, false, I->second.upper, nullptr});
+      }
+    }
+  }
+
+  for (auto L : LI.getLoopsInPreorder())
+    inferRelations(L);
+
+  for (auto &E : invariants)
+    SDEBUG(errs() << "Inferred " << E.second.size()
+                  << " invariants for loop " << E.first->getName() << "\n");
+  return false;
+}
+
+const std::vector<LoopInvariantInference::Invariant> &
+LoopInvariantInference::getInvariants(const BasicBlock *H) {
+  return invariants[H];
+}
+
+// Pass ID variable
+char LoopInvariantInference::ID = 0;
+
+StringRef LoopInvariantInference::getPassName() const {
+  return "Loop invariant inference";
+}
+} // namespace smack
@@ -5,12 +5,22 @@
 #include "smack/Debug.h"
 #include "smack/Naming.h"
 #include "smack/SmackOptions.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ValueSymbolTable.h"
+#include "llvm/Transforms/Utils.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+
+#define DEBUG_TYPE "smack-memory-safety"
 
 namespace smack {
 
@@ -40,18 +50,217 @@ void MemorySafetyChecker::insertMemoryLeakCheck(Instruction *I) {
   copyDbgMetadata(I, ci);
 }
 
-void MemorySafetyChecker::insertMemoryAccessCheck(Value *addr, Value *size,
-                                                  Instruction *I) {
+CallInst *MemorySafetyChecker::insertMemoryAccessCheck(Value *addr,
+                                                       Value *size,
+                                                       Instruction *I) {
   auto &M = *I->getParent()->getParent()->getParent();
   auto &C = M.getContext();
   auto T = PointerType::getUnqual(Type::getInt8Ty(C));
   auto ptrArg = CastInst::Create(Instruction::BitCast, addr, T, "", I);
-  auto sizeArg = CastInst::CreateBitOrPointerCast(size, T, "", I);
+  copyDbgMetadata(I, ptrArg);
+  Value *sizeArg;
+  if (auto CS = dyn_cast<Constant>(size))
+    sizeArg = ConstantExpr::getIntToPtr(CS, T);
+  else {
+    auto CI = CastInst::CreateBitOrPointerCast(size, T, "", I);
+    copyDbgMetadata(I, CI);
+    sizeArg = CI;
+  }
   auto ci =
       CallInst::Create(getSafetyCheckFunction(M), {ptrArg, sizeArg}, "", I);
-  copyDbgMetadata(I, ptrArg);
-  copyDbgMetadata(I, sizeArg);
   copyDbgMetadata(I, ci);
+  checks.push_back({ci, addr, size});
+  return ci;
+}
+
+void MemorySafetyChecker::removeMemoryAccessCheck(AccessCheck &C) {
+  SmallVector<Value *, 2> args(C.call->arg_begin(), C.call->arg_end());
+  C.call->eraseFromParent();
+  C.call = nullptr;
+  for (auto V : args)
+    RecursivelyDeleteTriviallyDeadInstructions(V);
+}
+
+namespace {
+// Returns true if I might deallocate memory, and thus invalidate the result of
+// a previous memory-safety check.
+bool mayFreeMemory(Instruction &I) {
+  auto CB = dyn_cast<CallBase>(&I);
+  if (!CB || isa<IntrinsicInst>(CB) || CB->onlyReadsMemory() ||
+      CB->hasFnAttr(Attribute::NoFree))
+    return false;
+  auto F = CB->getCalledFunction();
+  return !F || !F->hasName() ||
+         !(Naming::isSmackName(F->getName()) ||
+           F->getName().startswith("__VERIFIER_"));
+}
+
+// Returns true if I is a call that might not return to its caller, or might
+// block the current path, e.g., a call to __VERIFIER_assume. Checks cannot be
+// hoisted above such calls without introducing spurious violations.
+bool mayInterruptLoop(Instruction &I) {
+  auto CB = dyn_cast<CallBase>(&I);
+  if (!CB || isa<DbgInfoIntrinsic>(CB))
+    return false;
+  auto F = CB->getCalledFunction();
+  return !F || !F->hasName() ||
+         !(F->getName() == Naming::MEMORY_SAFETY_FUNCTION ||
+           F->getName().startswith("__VERIFIER_nondet") ||
+           (F->isIntrinsic() && !CB->doesNotReturn() &&
+            F->getIntrinsicID() != Intrinsic::trap));
+}
+} // namespace
+
+// Returns true if the memory-safety check C1 covers the check C2, i.e., C1
+// checks a range of the same object which includes the range checked by C2.
+bool MemorySafetyChecker::covers(const AccessCheck &C1,
+                                 const AccessCheck &C2) {
+  auto S1 = dyn_cast<ConstantInt>(C1.size);
+  auto S2 = dyn_cast<ConstantInt>(C2.size);
+  if (!S1 || !S2)
+    return C1.addr == C2.addr && C1.size == C2.size;
+  auto &DL = C1.call->getModule()->getDataLayout();
+  int64_t O1, O2;
+  auto B1 = GetPointerBaseWithConstantOffset(C1.addr, O1, DL);
+  auto B2 = GetPointerBaseWithConstantOffset(C2.addr, O2, DL);
+  return B1 == B2 && O1 <= O2 &&
+         O2 + S2->getSExtValue() <= O1 + S1->getSExtValue();
+}
+
+// Replaces the checks of accesses through an affine induction pointer of L,
+// e.g., a[i] for i = 0..n-1, by a single range check in the preheader of L.
+void MemorySafetyChecker::hoistLoopChecks(Loop *L, DominatorTree &DT,
+                                          LoopInfo &LI, ScalarEvolution &SE) {
+  auto preheader = L->getLoopPreheader();
+  auto latch = L->getLoopLatch();
+  auto exiting = L->getExitingBlock();
+  if (!preheader || !latch || !exiting)
+    return;
+
+  for (auto B : L->blocks())
+    for (auto &I : *B)
+      if (mayFreeMemory(I) || mayInterruptLoop(I))
+        return;
+
+  auto BTC = SE.getBackedgeTakenCount(L);
+  if (isa<SCEVCouldNotCompute>(BTC))
+    return;
+
+  Instruction *guard = nullptr;
+  SCEVExpander expander(SE, L->getHeader()->getModule()->getDataLayout(),
+                        "msc");
+  for (unsigned i = 0; i < checks.size(); ++i) {
+    auto &C = checks[i];
+    if (!C.call || LI.getLoopFor(C.call->getParent()) != L ||
+        !DT.dominates(C.call->getParent(), latch))
+      continue;
+
+    auto size = dyn_cast<ConstantInt>(C.size);
+    auto AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(C.addr));
+    if (!size || !AR || AR->getLoop() != L || !AR->isAffine())
+      continue;
+    auto step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+    if (!step)
+      continue;
+
+    // The check executes on each iteration up to and including the last one
+    // if it precedes the loop exit; otherwise it is skipped in the last one.
+    auto T = SE.getEffectiveSCEVType(AR->getType());
+    auto last = SE.getTruncateOrZeroExtend(BTC, T);
+    bool guarded = false;
+    if (!DT.dominates(C.call->getParent(), exiting)) {
+      guarded = !SE.isKnownPositive(BTC);
+      last = SE.getMinusSCEV(last, SE.getOne(T));
+    }
+    auto span = SE.getMulExpr(last, SE.getConstant(step->getAPInt().abs()));
+    auto low = step->getAPInt().isNegative()
+                   ? SE.getAddExpr(AR->getStart(), SE.getMulExpr(last, step))
+                   : AR->getStart();
+    auto range = SE.getAddExpr(span, SE.getConstant(T, size->getZExtValue()));
+
+    auto pt = preheader->getTerminator();
+    if (!isSafeToExpandAt(low, pt, SE) || !isSafeToExpandAt(range, pt, SE) ||
+        (guarded && !isSafeToExpandAt(BTC, pt, SE)))
+      continue;
+
+    if (guarded && !guard) {
+      // Only check the range if the loop body is executed at all.
+      auto N = expander.expandCodeFor(BTC, BTC->getType(), pt);
+      auto cond = new ICmpInst(pt, ICmpInst::ICMP_NE, N,
+                               ConstantInt::get(N->getType(), 0));
+      guard = SplitBlockAndInsertIfThen(cond, pt, false, nullptr, &DT, &LI);
+      preheader = L->getLoopPreheader();
+      // The split updates DT and LI, but not what SE cached on the loops
+      // around the new blocks.
+      SE.forgetTopmostLoop(L);
+      SE.forgetLoopDispositions(L);
+    }
+    pt = guarded ? guard : preheader->getTerminator();
+
+    SDEBUG(errs() << "Hoisting memory-safety check " << *C.call
+                  << " with range " << *low << " + " << *range << "\n");
+    auto addr = expander.expandCodeFor(low, C.addr->getType(), pt);
+    auto length = expander.expandCodeFor(range, T, pt);
+    auto ci = insertMemoryAccessCheck(addr, length, pt);
+    copyDbgMetadata(checks[i].call, ci);
+    removeMemoryAccessCheck(checks[i]);
+  }
+}
+
+// Removes each check which is dominated by a check which covers it, as long
+// as no deallocation can occur in between.
+void MemorySafetyChecker::removeRedundantChecks(Function &F,
+                                                DominatorTree &DT,
+                                                LoopInfo &LI) {
+  std::map<CallInst *, unsigned> index;
+  for (unsigned i = 0; i < checks.size(); ++i)
+    if (checks[i].call)
+      index[checks[i].call] = i;
+
+  std::vector<Instruction *> frees;
+  for (auto &I : instructions(F))
+    if (mayFreeMemory(I))
+      frees.push_back(&I);
+
+  // Visit checks in dominator-tree order, so that dominating checks are
+  // visited, and possibly removed, first.
+  std::vector<unsigned> kept, redundant;
+  for (auto N : depth_first(DT.getRootNode())) {
+    for (auto &I : *N->getBlock()) {
+      auto CI = dyn_cast<CallInst>(&I);
+      if (!CI || !index.count(CI))
+        continue;
+      auto &C = checks[index[CI]];
+      bool isRedundant = false;
+      for (auto j : kept) {
+        auto &D = checks[j];
+        if (!DT.dominates(D.call, C.call) || !covers(D, C))
+          continue;
+        isRedundant = true;
+        for (auto K : frees)
+          if (isPotentiallyReachable(D.call, K, nullptr, &DT, &LI) &&
+              isPotentiallyReachable(K, C.call, nullptr, &DT, &LI)) {
+            isRedundant = false;
+            break;
+          }
+        if (isRedundant)
+          break;
+      }
+      (isRedundant ? redundant : kept).push_back(index[CI]);
+    }
+  }
+
+  SDEBUG(errs() << "Removing " << redundant.size() << " of "
+                << redundant.size() + kept.size()
+                << " memory-safety checks in " << F.getName() << "\n");
+  for (auto i : redundant)
+    removeMemoryAccessCheck(checks[i]);
+}
+
+void MemorySafetyChecker::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<DominatorTreeWrapperPass>();
+  AU.addRequired<LoopInfoWrapperPass>();
+  AU.addRequired<ScalarEvolutionWrapperPass>();
 }
 
 bool MemorySafetyChecker::runOnFunction(Function &F) {
@@ -59,7 +268,19 @@ bool MemorySafetyChecker::runOnFunction(Function &F) {
       !SmackOptions::shouldCheckFunction(F.getName()))
     return false;
 
+  checks.clear();
   this->visit(F);
+
+  auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  auto &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+
+  // Inner loops first, so that their hoisted checks are outside of them.
+  auto loops = LI.getLoopsInPreorder();
+  for (auto L = loops.rbegin(); L != loops.rend(); ++L)
+    hoistLoopChecks(*L, DT, LI, SE);
+  removeRedundantChecks(F, DT, LI);
+  checks.clear();
   return true;
 }
 
@@ -71,34 +292,32 @@ void MemorySafetyChecker::visitReturnInst(llvm::ReturnInst &I) {
 }
 
 namespace {
-Value *accessSizeAsPointer(Module &M, Value *V) {
+Value *accessSize(Module &M, Value *V) {
   auto T = dyn_cast<PointerType>(V->getType());
   assert(T && "expected pointer type");
 
-  return ConstantExpr::getIntToPtr(
-      ConstantInt::get(
-          Type::getInt64Ty(M.getContext()),
-          M.getDataLayout().getTypeStoreSize(T->getPointerElementType())),
-      PointerType::getUnqual(Type::getInt8Ty(M.getContext())));
+  return ConstantInt::get(
+      Type::getInt64Ty(M.getContext()),
+      M.getDataLayout().getTypeStoreSize(T->getPointerElementType()));
 }
 
-Value *accessSizeAsPointer(LoadInst &I) {
+Value *accessSize(LoadInst &I) {
   auto &M = *I.getParent()->getParent()->getParent();
-  return accessSizeAsPointer(M, I.getPointerOperand());
+  return accessSize(M, I.getPointerOperand());
 }
 
-Value *accessSizeAsPointer(StoreInst &I) {
+Value *accessSize(StoreInst &I) {
   auto &M = *I.getParent()->getParent()->getParent();
-  return accessSizeAsPointer(M, I.getPointerOperand());
+  return accessSize(M, I.getPointerOperand());
 }
 } // namespace
 
 void MemorySafetyChecker::visitLoadInst(LoadInst &I) {
-  insertMemoryAccessCheck(I.getPointerOperand(), accessSizeAsPointer(I), &I);
+  insertMemoryAccessCheck(I.getPointerOperand(), accessSize(I), &I);
 }
 
 void MemorySafetyChecker::visitStoreInst(StoreInst &I) {
-  insertMemoryAccessCheck(I.getPointerOperand(), accessSizeAsPointer(I), &I);
+  insertMemoryAccessCheck(I.getPointerOperand(), accessSize(I), &I);
 }
 
 void MemorySafetyChecker::visitMemSetInst(MemSetInst &I) {
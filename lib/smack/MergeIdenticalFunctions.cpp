@@ -0,0 +1,224 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+
+//
+// This pass folds functions whose translations coincide, e.g., instantiations
+// of Rust generics and C++ templates over types which SMACK translates alike,
+// into a single procedure. Candidates are bucketed by the structural hash of
+// LLVM's function comparator, and compared with it. Since the comparator also
+// equates types which are translated differently, e.g., pointers and integers
+// of pointer width, the instructions of both functions are compared once more
+// in lockstep. Finally, the memory regions of their arguments and return
+// values must coincide. DSA is context-insensitive, and the regions of a
+// procedure are global maps, thus the body of the remaining function accesses
+// the regions of its own arguments; were those distinct from the regions of
+// the duplicate, the callers of the duplicate would read and write the wrong
+// maps. Arguments which are only compared never reach memory, and are exempt.
+//
+// Uses of a duplicate are redirected to the remaining function when the
+// signatures are identical and the address of the duplicate is insignificant;
+// otherwise the duplicate becomes a thunk which calls the remaining function.
+//
+
+#include "smack/MergeIdenticalFunctions.h"
+#include "smack/Debug.h"
+#include "smack/Naming.h"
+#include "smack/SmackOptions.h"
+#include "smack/SmackWarnings.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Transforms/Utils/FunctionComparator.h"
+#include <map>
+#include <string>
+#include <vector>
+
+#define DEBUG_TYPE "smack-merge-functions"
+
+namespace smack {
+
+using namespace llvm;
+
+namespace {
+// Returns true if the values of types A and B are translated alike, i.e.,
+// they differ in the pointee types of pointers at most.
+bool alike(Type *A, Type *B) {
+  if (A == B)
+    return true;
+
+  if (A->isPointerTy() && B->isPointerTy())
+    return A->getPointerAddressSpace() == B->getPointerAddressSpace();
+
+  if (A->getTypeID() != B->getTypeID() || A->getNumContainedTypes() == 0 ||
+      A->getNumContainedTypes() != B->getNumContainedTypes())
+    return false;
+
+  if (A->isArrayTy() && A->getArrayNumElements() != B->getArrayNumElements())
+    return false;
+
+  if (auto VT = dyn_cast<VectorType>(A))
+    if (VT->getElementCount() != cast<VectorType>(B)->getElementCount())
+      return false;
+
+  if (auto ST = dyn_cast<StructType>(A))
+    if (ST->isPacked() != cast<StructType>(B)->isPacked())
+      return false;
+
+  if (auto FT = dyn_cast<FunctionType>(A))
+    if (FT->isVarArg() != cast<FunctionType>(B)->isVarArg())
+      return false;
+
+  for (unsigned i = 0; i < A->getNumContainedTypes(); ++i)
+    if (!alike(A->getContainedType(i), B->getContainedType(i)))
+      return false;
+
+  return true;
+}
+
+Value *castTo(IRBuilder<> &B, Value *V, Type *T) {
+  auto S = V->getType();
+  if (S == T)
+    return V;
+
+  if (S->isStructTy() || S->isArrayTy()) {
+    Value *R = UndefValue::get(T);
+    unsigned n = S->isStructTy() ? S->getStructNumElements()
+                                 : S->getArrayNumElements();
+    for (unsigned i = 0; i < n; ++i) {
+      auto E = T->isStructTy() ? T->getStructElementType(i)
+                               : T->getArrayElementType();
+      R = B.CreateInsertValue(R, castTo(B, B.CreateExtractValue(V, i), E), i);
+    }
+    return R;
+  }
+
+  return B.CreateBitCast(V, T);
+}
+
+// Returns true if memory may be accessed through the pointer argument A,
+// i.e., it has uses besides comparisons.
+bool mayAccess(const Argument &A) {
+  for (auto U : A.users())
+    if (!isa<ICmpInst>(U))
+      return true;
+  return false;
+}
+} // namespace
+
+bool MergeIdenticalFunctions::isMergeable(Function &F) {
+  auto name = F.getName();
+  return !F.isDeclaration() && !F.isVarArg() && !F.isInterposable() &&
+         !SmackOptions::isEntryPoint(name) && !Naming::isSmackName(name) &&
+         !Naming::isSmackGeneratedName(name.str()) &&
+         !Naming::isRustPanic(name) && !name.startswith("__VERIFIER_") &&
+         !name.startswith("__CONTRACT") && !name.startswith("pthread_");
+}
+
+bool MergeIdenticalFunctions::translatesAlike(Function &F, Function &G) {
+  if (!alike(F.getFunctionType(), G.getFunctionType()))
+    return false;
+
+  for (auto A = F.arg_begin(), B = G.arg_begin(); A != F.arg_end(); ++A, ++B)
+    if (A->getType()->isPointerTy() && (mayAccess(*A) || mayAccess(*B)) &&
+        DSA->getNode(&*A) != DSA->getNode(&*B))
+      return false;
+
+  auto I = inst_begin(F), J = inst_begin(G);
+  for (; I != inst_end(F) && J != inst_end(G); ++I, ++J) {
+    if (I->getOpcode() != J->getOpcode() ||
+        I->getNumOperands() != J->getNumOperands() ||
+        !alike(I->getType(), J->getType()))
+      return false;
+
+    for (unsigned i = 0; i < I->getNumOperands(); ++i)
+      if (!alike(I->getOperand(i)->getType(), J->getOperand(i)->getType()))
+        return false;
+
+    if (auto AI = dyn_cast<AllocaInst>(&*I))
+      if (!alike(AI->getAllocatedType(),
+                 cast<AllocaInst>(&*J)->getAllocatedType()))
+        return false;
+
+    if (auto RI = dyn_cast<ReturnInst>(&*I))
+      if (auto V = RI->getReturnValue())
+        if (V->getType()->isPointerTy() &&
+            DSA->getNode(V) !=
+                DSA->getNode(cast<ReturnInst>(&*J)->getReturnValue()))
+          return false;
+  }
+  return I == inst_end(F) && J == inst_end(G);
+}
+
+void MergeIdenticalFunctions::merge(Function *F, Function *G) {
+  SDEBUG(errs() << "merging " << G->getName() << " into " << F->getName()
+                << "\n");
+
+  if (F->getFunctionType() == G->getFunctionType() &&
+      (G->hasGlobalUnnamedAddr() || !G->hasAddressTaken())) {
+    G->replaceAllUsesWith(F);
+    G->eraseFromParent();
+    ++numMerged;
+    return;
+  }
+
+  auto linkage = G->getLinkage();
+  G->deleteBody();
+  G->setLinkage(linkage);
+  IRBuilder<> B(BasicBlock::Create(G->getContext(), "", G));
+  std::vector<Value *> args;
+  auto FT = F->getFunctionType();
+  for (auto &A : G->args())
+    args.push_back(castTo(B, &A, FT->getParamType(A.getArgNo())));
+  auto CI = B.CreateCall(F, args);
+  CI->setCallingConv(F->getCallingConv());
+  if (G->getReturnType()->isVoidTy())
+    B.CreateRetVoid();
+  else
+    B.CreateRet(castTo(B, CI, G->getReturnType()));
+  ++numThunks;
+}
+
+void MergeIdenticalFunctions::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<DSAWrapper>();
+}
+
+bool MergeIdenticalFunctions::runOnModule(Module &M) {
+  DSA = &getAnalysis<DSAWrapper>();
+
+  std::vector<Function *> candidates;
+  for (auto &F : M)
+    if (isMergeable(F))
+      candidates.push_back(&F);
+
+  // The functions kept so far, bucketed by their structural hash.
+  std::map<FunctionComparator::FunctionHash, std::vector<Function *>> kept;
+  GlobalNumberState GN;
+
+  for (auto G : candidates) {
+    auto &bucket = kept[FunctionComparator::functionHash(*G)];
+    bool merged = false;
+    for (auto F : bucket) {
+      if (FunctionComparator(F, G, &GN).compare() == 0 &&
+          translatesAlike(*F, *G)) {
+        merge(F, G);
+        merged = true;
+        break;
+      }
+    }
+    if (!merged)
+      bucket.push_back(G);
+  }
+
+  SmackWarnings::warnInfo("merged " + std::to_string(numMerged) +
+                          " functions, and replaced " +
+                          std::to_string(numThunks) + " by thunks");
+  return numMerged + numThunks > 0;
+}
+
+// Pass ID variable
+char MergeIdenticalFunctions::ID = 0;
+
+StringRef MergeIdenticalFunctions::getPassName() const {
+  return "Merge identical functions";
+}
+} // namespace smack
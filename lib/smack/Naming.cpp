@@ -57,6 +57,7 @@ const std::string Naming::MALLOC_TOP = "$MALLOC_TOP";
 
 const std::string Naming::BRANCH_CONDITION_ANNOTATION = "branchcond";
 const std::string Naming::LOOP_INVARIANT_ANNOTATION = "loopinvariant";
+const std::string Naming::THREAD_LOCAL_ANNOTATION = "thread_local";
 
 const std::string Naming::MEM_OP = "$mop";
 const std::string Naming::REC_MEM_OP = "boogie_si_record_mop";
@@ -90,6 +91,7 @@ const std::string Naming::CONTRACT_EXPR = "$expr";
 const std::string Naming::MEMORY_SAFETY_FUNCTION =
     "__SMACK_check_memory_safety";
 const std::string Naming::MEMORY_LEAK_FUNCTION = "__SMACK_check_memory_leak";
+const std::string Naming::OVERFLOW_PREDICATE = "__SMACK_overflow";
 const std::string Naming::INT_WRAP_SIGNED_FUNCTION = "$tos";
 const std::string Naming::INT_WRAP_UNSIGNED_FUNCTION = "$tou";
 
@@ -0,0 +1,142 @@
+//
+// This file is distributed under the MIT License. See LICENSE for details.
+//
+
+//
+// This pass rewrites integer arithmetic to the narrowest bit width which
+// preserves its semantics, e.g., the increment of a loop counter bounded by
+// 16 is computed with 8-bit rather than 32-bit arithmetic. An operation is
+// narrowed when only its low bits are demanded by its users, or when the
+// ranges of its operands and result fit into the narrower width. This
+// reduces the cost of bit-blasting in the bit-vector encoding.
+//
+
+#define DEBUG_TYPE "smack-narrow"
+#include "smack/NarrowIntegerOps.h"
+#include "smack/Debug.h"
+#include "smack/Naming.h"
+#include "smack/SmackWarnings.h"
+#include "llvm/Analysis/DemandedBits.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/IR/ConstantRange.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include <string>
+#include <vector>
+
+namespace smack {
+
+using namespace llvm;
+
+namespace {
+// Narrow widths which the prelude defines bit-vector operations for
+const std::vector<unsigned> NARROW_WIDTHS{8, 16, 32};
+
+bool isNarrowable(const BinaryOperator *I) {
+  switch (I->getOpcode()) {
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::Mul:
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+    return I->getType()->isIntegerTy() &&
+           I->getType()->getIntegerBitWidth() > NARROW_WIDTHS.front();
+  default:
+    return false;
+  }
+}
+} // namespace
+
+void NarrowIntegerOps::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<DemandedBitsWrapperPass>();
+  AU.addRequired<LazyValueInfoWrapperPass>();
+}
+
+// Returns the narrowest width at which I can be computed, or its own width if
+// none exists. The low bits of the result of these operations only depend on
+// the low bits of their operands, so I can be computed at a narrower width
+// when only those bits are demanded, in which case the result is
+// zero-extended, or when its result fits the width as a signed value, in
+// which case it is sign-extended.
+unsigned NarrowIntegerOps::getNarrowWidth(BinaryOperator *I, bool &isSigned) {
+  auto &DB = getAnalysis<DemandedBitsWrapperPass>().getDemandedBits();
+  auto &LVI = getAnalysis<LazyValueInfoWrapperPass>().getLVI();
+  unsigned width = I->getType()->getIntegerBitWidth();
+
+  auto demanded = DB.getDemandedBits(I);
+  unsigned demandedWidth = width - demanded.countLeadingZeros();
+
+  auto L = LVI.getConstantRange(I->getOperand(0), I, false);
+  auto R = LVI.getConstantRange(I->getOperand(1), I, false);
+  auto result = L.binaryOp(I->getOpcode(), R);
+  unsigned resultWidth =
+      std::max(result.getSignedMin().getMinSignedBits(),
+               result.getSignedMax().getMinSignedBits());
+
+  for (auto w : NARROW_WIDTHS) {
+    if (w >= width)
+      break;
+    if (demandedWidth <= w) {
+      isSigned = false;
+      return w;
+    }
+    if (!result.isFullSet() && resultWidth <= w) {
+      isSigned = true;
+      return w;
+    }
+  }
+  return width;
+}
+
+void NarrowIntegerOps::narrow(BinaryOperator *I, unsigned width,
+                              bool isSigned) {
+  SDEBUG(errs() << "Narrowing " << *I << " to i" << width << "\n");
+  IRBuilder<> B(I);
+  auto T = B.getIntNTy(width);
+  auto N = B.CreateBinOp(I->getOpcode(), B.CreateTrunc(I->getOperand(0), T),
+                         B.CreateTrunc(I->getOperand(1), T));
+  auto E = isSigned ? B.CreateSExt(N, I->getType())
+                    : B.CreateZExt(N, I->getType());
+  if (!isa<Constant>(E))
+    E->takeName(I);
+  I->replaceAllUsesWith(E);
+  I->eraseFromParent();
+}
+
+bool NarrowIntegerOps::runOnFunction(Function &F) {
+  if (Naming::isSmackName(F.getName()))
+    return false;
+
+  std::vector<std::tuple<BinaryOperator *, unsigned, bool>> worklist;
+  for (auto &I : instructions(F)) {
+    auto BO = dyn_cast<BinaryOperator>(&I);
+    if (!BO || !isNarrowable(BO))
+      continue;
+    numOps++;
+    bool isSigned = false;
+    unsigned width = getNarrowWidth(BO, isSigned);
+    if (width < BO->getType()->getIntegerBitWidth())
+      worklist.emplace_back(BO, width, isSigned);
+  }
+
+  for (auto &W : worklist)
+    narrow(std::get<0>(W), std::get<1>(W), std::get<2>(W));
+  numNarrowed += worklist.size();
+  return !worklist.empty();
+}
+
+bool NarrowIntegerOps::doFinalization(Module &M) {
+  SmackWarnings::warnInfo("narrowed " + std::to_string(numNarrowed) + " of " +
+                          std::to_string(numOps) + " integer operations");
+  return false;
+}
+
+// Pass ID variable
+char NarrowIntegerOps::ID = 0;
+
+StringRef NarrowIntegerOps::getPassName() const {
+  return "Narrow integer operations";
+}
+} // namespace smack
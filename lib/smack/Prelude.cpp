@@ -7,6 +7,7 @@
 
 #include <functional>
 #include <map>
+#include <set>
 #include <tuple>
 
 namespace smack {
@@ -294,7 +295,13 @@ struct IntOpGen::IntArithOp : public IntOp {
     std::string type = getIntTypeName(size);
     std::string name = "$" + opName;
 
-    if (auto bop = dyn_cast<BuiltinOp<IntOp::attrT>>(intOp))
+    if (SmackOptions::BitPreciseBitwiseOps && isBitwise() && size > 1)
+      // bitwise int functions computed by their bv counterparts
+      // e.g.: function {:inline} $lshr.i32(i1: i32, i2: i32) returns (i32)
+      // { $bv2uint.32($lshr.bv32($int2bv.32(i1), $int2bv.32(i2))) }
+      return inlinedOp(name, {type}, makeIntVars(arity, type), type,
+                       bitwiseExpr(size));
+    else if (auto bop = dyn_cast<BuiltinOp<IntOp::attrT>>(intOp))
       // builtin int functions
       // e.g.: function {:builtin "div"} $sdiv.i1(i1: i1, i2: i1) returns (i1);
       // return builtinOp(name, makeBuiltinAttr(op.substr(1)), {type},
@@ -342,11 +349,45 @@ struct IntOpGen::IntArithOp : public IntOp {
         (!SmackOptions::BitPrecisePointers && alsoUsedByPtr))
       funcs.push_back(getIntFunc(size));
     if (SmackOptions::BitPrecise ||
-        (SmackOptions::BitPrecisePointers && alsoUsedByPtr))
+        (SmackOptions::BitPrecisePointers && alsoUsedByPtr) ||
+        (SmackOptions::BitPreciseBitwiseOps && isBitwise()))
       funcs.push_back(getBvFunc(size));
     return funcs;
   }
 
+  bool isBitwise() const {
+    static const std::set<std::string> bitwiseOps{"shl", "lshr", "ashr",
+                                                  "and", "or",   "xor"};
+    return bitwiseOps.count(opName);
+  }
+
+  // generate inlined int bitwise function body such as
+  // `if (i1 < 0 || i2 < 0) && r >= 2147483648 then r - 4294967296 else r`
+  // where r is `$bv2uint.32($and.bv32($int2bv.32(i1), $int2bv.32(i2)))`,
+  // i.e., the result is interpreted as a signed value when its operands
+  // (or the shifted value, for shifts) are
+  const Expr *bitwiseExpr(unsigned size) const {
+    auto i1 = makeIntVarExpr(1);
+    auto i2 = makeIntVarExpr(2);
+    auto r = Expr::fn(
+        indexedName("$bv2uint", {size}),
+        Expr::fn(indexedName("$" + opName, {getBvTypeName(size)}),
+                 Expr::fn(indexedName("$int2bv", {size}), i1),
+                 Expr::fn(indexedName("$int2bv", {size}), i2)));
+    auto zero = Expr::lit(0ULL);
+    const Expr *isSigned;
+    if (opName == "lshr")
+      return r;
+    else if (opName == "shl" || opName == "ashr")
+      isSigned = Expr::lt(i1, zero);
+    else
+      isSigned = Expr::or_(Expr::lt(i1, zero), Expr::lt(i2, zero));
+    return Expr::ifThenElse(
+        Expr::and_(isSigned, new BinExpr(BinExpr::Gte, r,
+                                         Expr::lit(getIntLimit(size - 1), 0))),
+        new BinExpr(BinExpr::Minus, r, Expr::lit(getIntLimit(size), 0)), r);
+  }
+
   // generate inlined int arithmetic function body such as `i1+i2`
   template <BinExpr::Binary OP> static const Expr *intArithExpr(unsigned size) {
     return new BinExpr(OP, makeIntVarExpr(1), makeIntVarExpr(2));
@@ -721,6 +762,74 @@ void IntOpGen::generatePreds(std::stringstream &s) const {
       printFuncs(pred.getFuncs(size), s);
 }
 
+void IntOpGen::generateOverflowPreds(std::stringstream &s) const {
+  describe("Bit-vector overflow predicates", s);
+
+  // Overflow of the operation computed at the native bit width, which avoids
+  // the double-width arithmetic of the integer encoding, e.g.,
+  // function {:inline} $uadd.ovf.bv32.bool(i1: bv32, i2: bv32) returns (bool)
+  //   { $ult.bv32.bool($add.bv32(i1, i2), i1) }
+  // Multiplication is checked via division unless solver builtins are enabled.
+  const std::vector<std::string> ops{"uadd", "sadd", "usub",
+                                     "ssub", "umul", "smul"};
+  for (auto size : INTEGER_SIZES) {
+    std::string type = getBvTypeName(size);
+    auto i1 = makeIntVarExpr(1);
+    auto i2 = makeIntVarExpr(2);
+    auto zero = Expr::lit(0ULL, size);
+    auto op = [&](std::string name, const Expr *l, const Expr *r) {
+      return Expr::fn(indexedName("$" + name, {type}), l, r);
+    };
+    auto pred = [&](std::string name, const Expr *l, const Expr *r) {
+      return Expr::fn(indexedName("$" + name, {type, Naming::BOOL_TYPE}), l,
+                      r);
+    };
+    auto neg = [&](const Expr *e) { return pred("slt", e, zero); };
+    std::map<std::string, const Expr *> bodies{
+        {"uadd", pred("ult", op("add", i1, i2), i1)},
+        {"sadd", Expr::and_(Expr::eq(neg(i1), neg(i2)),
+                            Expr::neq(neg(op("add", i1, i2)), neg(i1)))},
+        {"usub", pred("ult", i1, i2)},
+        {"ssub", Expr::and_(Expr::neq(neg(i1), neg(i2)),
+                            Expr::neq(neg(op("sub", i1, i2)), neg(i1)))}};
+    if (SmackOptions::BitVectorOverflowBuiltins) {
+      // e.g., function {:bvbuiltin "bvumul_noovfl"}
+      //   $umul_noovfl.bv32.bool(i1: bv32, i2: bv32) returns (bool);
+      for (std::string b : {"umul_noovfl", "smul_noovfl", "smul_noudfl"})
+        s << builtinOp("$" + b, makeBvbuiltinAttr("bv" + b),
+                       {type, Naming::BOOL_TYPE}, makeIntVars(2, type),
+                       Naming::BOOL_TYPE)
+          << "\n";
+      bodies["umul"] = Expr::not_(pred("umul_noovfl", i1, i2));
+      bodies["smul"] = Expr::not_(Expr::and_(pred("smul_noovfl", i1, i2),
+                                             pred("smul_noudfl", i1, i2)));
+    } else {
+      auto ones = Expr::lit(APInt::getAllOnesValue(size).toString(10, false),
+                            size);
+      auto min = Expr::lit(getIntLimit(size - 1), size);
+      bodies["umul"] =
+          Expr::and_(Expr::neq(i1, zero),
+                     Expr::neq(op("udiv", op("mul", i1, i2), i1), i2));
+      bodies["smul"] = Expr::and_(
+          Expr::neq(i1, zero),
+          Expr::or_(Expr::and_(Expr::eq(i1, ones), Expr::eq(i2, min)),
+                    Expr::neq(op("sdiv", op("mul", i1, i2), i1), i2)));
+    }
+    for (auto &name : ops) {
+      std::string ovf = "$" + name + ".ovf";
+      s << inlinedOp(ovf, {type, Naming::BOOL_TYPE}, makeIntVars(2, type),
+                     Naming::BOOL_TYPE, bodies.at(name))
+        << "\n";
+      s << inlinedOp(ovf, {type}, makeIntVars(2, type), getBvTypeName(1),
+                     Expr::ifThenElse(
+                         Expr::fn(indexedName(ovf, {type, Naming::BOOL_TYPE}),
+                                  i1, i2),
+                         Expr::lit(1, 1), Expr::lit(0, 1)))
+        << "\n";
+    }
+  }
+}
+
 struct IntOpGen::IntConv {
   typedef const Attr *(*attrT)(unsigned, unsigned);
   typedef const Expr *(*castExprT)(unsigned, unsigned);
@@ -1041,6 +1150,22 @@ void IntOpGen::generateBvIntConvs(std::stringstream &s) const {
     s << Decl::function(indexedName("$bv2int", {ptrSize}), {{"i", bt}}, it,
                         nullptr, {makeBuiltinAttr("bv2nat")})
       << "\n";
+  if (SmackOptions::BitPreciseBitwiseOps && !SmackOptions::BitPrecise) {
+    // conversions used by the int bitwise operations, e.g.,
+    // function {:builtin "bv2nat"} $bv2uint.32(i: bv32) returns (i32);
+    for (auto size : INTEGER_SIZES) {
+      std::string b = std::to_string(size);
+      if (size != ptrSize)
+        s << Decl::function(indexedName("$int2bv", {size}),
+                            {{"i", getIntTypeName(size)}}, getBvTypeName(size),
+                            nullptr, {makeBuiltinAttr("(_ int2bv " + b + ")")})
+          << "\n";
+      s << Decl::function(indexedName("$bv2uint", {size}),
+                          {{"i", getBvTypeName(size)}}, getIntTypeName(size),
+                          nullptr, {makeBuiltinAttr("bv2nat")})
+        << "\n";
+    }
+  }
   s << "\n";
 }
 
@@ -1048,6 +1173,8 @@ void IntOpGen::generate(std::stringstream &s) const {
   generateBvIntConvs(s);
   generateArithOps(s);
   generatePreds(s);
+  if (SmackOptions::BitPrecise)
+    generateOverflowPreds(s);
   generateMemOps(s);
   generateConvOps(s);
   generateExtractValueFuncs(s);
@@ -1116,9 +1243,16 @@ void MemDeclGen::generateMemoryMaps(std::stringstream &s) const {
                " regions)",
            s);
 
-  for (auto M : prelude.rep.memoryMaps())
-    s << "var " << M.first << ": " << M.second << ";"
+  // Maps of thread-local regions are annotated, so that concurrency back ends
+  // need not consider context switches at their accesses.
+  unsigned i = 0;
+  for (auto M : prelude.rep.memoryMaps()) {
+    s << "var ";
+    if (prelude.rep.regions->get(i++).isThreadLocal())
+      s << "{:" << Naming::THREAD_LOCAL_ANNOTATION << "} ";
+    s << M.first << ": " << M.second << ";"
       << "\n";
+  }
 
   s << "\n";
 }
@@ -55,6 +55,8 @@ void Region::init(const Value *V, unsigned length) {
   incomplete = !representative || representative->isIncomplete();
   complicated = !representative || isComplicated(representative);
   collapsed = !representative || representative->isOffsetCollapsed();
+  threadLocal = !incomplete && !complicated &&
+                DSA->isThreadLocal(representative);
 }
 
 Region::Region(const Value *V) {
@@ -82,6 +84,7 @@ void Region::merge(Region &R) {
   incomplete = incomplete || R.incomplete;
   complicated = complicated || R.complicated;
   collapsed = collapsed || R.collapsed;
+  threadLocal = threadLocal && R.threadLocal;
   type = (bytewise || collapse) ? NULL : type;
 }
 
@@ -111,6 +114,8 @@ void Region::print(raw_ostream &O) {
     O << "L";
   if (allocated)
     O << "A";
+  if (threadLocal)
+    O << "T";
   O << "}";
 }
 
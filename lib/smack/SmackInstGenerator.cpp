@@ -5,6 +5,7 @@
 #include "smack/SmackInstGenerator.h"
 #include "smack/BoogieAst.h"
 #include "smack/Debug.h"
+#include "smack/LoopInvariantInference.h"
 #include "smack/Naming.h"
 #include "smack/SmackOptions.h"
 #include "smack/SmackRep.h"
@@ -145,10 +146,40 @@ void SmackInstGenerator::processInstruction(llvm::Instruction &inst) {
   nextInst++;
 }
 
+void SmackInstGenerator::generateLoopInvariants(llvm::BasicBlock &bb) {
+  for (auto &I : invariants->getInvariants(&bb)) {
+    auto T = I.phi->getType();
+    auto width = T->getIntegerBitWidth();
+    const Expr *B;
+    if (!I.bound)
+      B = rep->integerLit((long long)I.offset, width);
+    else {
+      B = rep->expr(I.bound, I.isUnsigned, true);
+      if (I.offset)
+        B = Expr::fn(rep->opName(I.offset > 0 ? "$add" : "$sub", {T}), B,
+                     rep->integerLit((unsigned long long)std::abs(I.offset),
+                                     width));
+    }
+    auto op = I.upper ? BinExpr::Lte : BinExpr::Gte;
+    const Expr *E = new BinExpr(op, rep->expr(I.phi), B);
+    if (I.init)
+      E = Expr::impl(new BinExpr(op, rep->expr(I.init), B), E);
+    // The verifier checks the invariant, so that an imprecise inference is
+    // reported rather than assumed, and then assumes it.
+    emit(Stmt::assert_(E, {Attr::attr(Naming::LOOP_INVARIANT_ANNOTATION)}));
+    emit(Stmt::assume(E, Attr::attr(Naming::LOOP_INVARIANT_ANNOTATION)));
+  }
+}
+
 void SmackInstGenerator::visitBasicBlock(llvm::BasicBlock &bb) {
   nextInst = bb.begin();
   currBlock = getBlock(&bb);
 
+  // Boogie considers the assertions and assumptions at the beginning of the
+  // loop head block to be checked and free loop invariants, respectively.
+  if (invariants && loops.isLoopHeader(&bb))
+    generateLoopInvariants(bb);
+
   auto *F = bb.getParent();
   if (&bb == &F->getEntryBlock()) {
     for (auto &I : bb.getInstList()) {
@@ -341,7 +372,8 @@ void SmackInstGenerator::visitBinaryOperator(llvm::BinaryOperator &I) {
   if (rep->isBitwiseOp(&I) && I.getType()->getIntegerBitWidth() > 1)
     SmackWarnings::warnOverApproximate(
         std::string("bitwise operation ") + I.getOpcodeName(),
-        {&SmackOptions::BitPrecise}, currBlock, &I);
+        {&SmackOptions::BitPrecise, &SmackOptions::BitPreciseBitwiseOps},
+        currBlock, &I, SmackWarnings::FlagRelation::Or);
   if (rep->isFpArithOp(&I))
     SmackWarnings::warnOverApproximate(
         std::string("floating-point operation ") + I.getOpcodeName(),
@@ -660,6 +692,11 @@ void SmackInstGenerator::visitCallInst(llvm::CallInst &ci) {
     // Skip this assertion if we shouldn't check in the parent function
     return;
 
+  } else if (name.startswith(Naming::OVERFLOW_PREDICATE + ".")) {
+    // Overflow predicates are pure prelude functions, not procedures
+    emit(Stmt::assign(rep->expr(&ci), rep->overflowPredicate(ci)));
+    return;
+
   } else if (name.find(Naming::VALUE_PROC) != StringRef::npos) {
     emit(rep->valueAnnotation(ci));
 
@@ -5,6 +5,7 @@
 #include "smack/SmackModuleGenerator.h"
 #include "smack/BoogieAst.h"
 #include "smack/Debug.h"
+#include "smack/LoopInvariantInference.h"
 #include "smack/Naming.h"
 #include "smack/Prelude.h"
 #include "smack/Regions.h"
@@ -25,6 +26,8 @@ void SmackModuleGenerator::getAnalysisUsage(llvm::AnalysisUsage &AU) const {
   AU.setPreservesAll();
   AU.addRequired<llvm::LoopInfoWrapperPass>();
   AU.addRequired<Regions>();
+  if (SmackOptions::InferLoopInvariants)
+    AU.addRequired<LoopInvariantInference>();
 }
 
 bool SmackModuleGenerator::runOnModule(llvm::Module &m) {
@@ -72,7 +75,10 @@ void SmackModuleGenerator::generateProgram(llvm::Module &M) {
       for (auto P : procs) {
         SmackInstGenerator igen(
             getAnalysis<LoopInfoWrapperPass>(F).getLoopInfo(), &rep, P,
-            &naming);
+            &naming,
+            SmackOptions::InferLoopInvariants
+                ? &getAnalysis<LoopInvariantInference>(F)
+                : nullptr);
         SDEBUG(errs() << "Generating body for " << naming.get(F) << "\n");
         igen.visit(F);
         SDEBUG(errs() << "\n");
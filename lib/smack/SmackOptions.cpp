@@ -50,15 +50,30 @@ const llvm::cl::opt<bool> SmackOptions::BitPrecisePointers(
     "bit-precise-pointers",
     llvm::cl::desc("Model pointer values as bit-vectors."));
 
+const llvm::cl::opt<bool> SmackOptions::BitVectorOverflowBuiltins(
+    "bv-overflow-builtins",
+    llvm::cl::desc("Use solver builtins (e.g., Z3's bvumul_noovfl) to detect "
+                   "bit-vector multiplication overflow."));
+
 const llvm::cl::opt<bool>
     SmackOptions::AddTiming("timing-annotations",
                             llvm::cl::desc("Add timing annotations."));
 
+const llvm::cl::opt<bool> SmackOptions::BitPreciseBitwiseOps(
+    "bit-precise-bitwise-ops",
+    llvm::cl::desc("Model bitwise operations as bit-vector operations, "
+                   "converting their operands from and results to integers."));
+
 const llvm::cl::opt<bool> SmackOptions::RewriteBitwiseOps(
     "rewrite-bitwise-ops",
     llvm::cl::desc(
         "Provides models for bitwise operations in integer encoding."));
 
+const llvm::cl::opt<bool> SmackOptions::ScalarizeVectors(
+    "scalarize-vectors",
+    llvm::cl::desc("Lower vector operations, loads, and stores into per-lane "
+                   "scalar operations."));
+
 const llvm::cl::opt<bool> SmackOptions::NoMemoryRegionSplitting(
     "no-memory-splitting",
     llvm::cl::desc("Disable splitting memory into regions."));
@@ -81,6 +96,34 @@ const llvm::cl::opt<bool> SmackOptions::FailOnLoopExit(
     "fail-on-loop-exit",
     llvm::cl::desc("Add assert(false) to the end of each loop"));
 
+const llvm::cl::opt<bool> SmackOptions::InferLoopInvariants(
+    "infer-loop-invariants",
+    llvm::cl::desc("Infer interval loop invariants, and check and assume "
+                   "them at loop headers"));
+
+const llvm::cl::opt<bool> SmackOptions::LazySequentialization(
+    "lazy-sequentialization",
+    llvm::cl::desc("Sequentialize pthread programs with bounded rounds"));
+
+const llvm::cl::opt<unsigned> SmackOptions::SequentializationRounds(
+    "sequentialization-rounds",
+    llvm::cl::desc("Number of scheduling rounds of lazy sequentialization"),
+    llvm::cl::init(2));
+
+const llvm::cl::opt<bool> SmackOptions::MergeFunctions(
+    "merge-functions",
+    llvm::cl::desc("Merge functions whose translations are identical"));
+
+const llvm::cl::opt<bool> SmackOptions::InlineLeafFunctions(
+    "inline-leaf-functions",
+    llvm::cl::desc("Inline small non-recursive leaf functions"));
+
+const llvm::cl::opt<unsigned> SmackOptions::InlineLeafThreshold(
+    "inline-leaf-threshold",
+    llvm::cl::desc("Bound on the estimated verification-condition size of "
+                   "inlined leaf functions"),
+    llvm::cl::init(16));
+
 const llvm::cl::opt<LLVMAssumeType> SmackOptions::LLVMAssumes(
     "llvm-assumes",
     llvm::cl::desc(
@@ -101,6 +144,29 @@ const llvm::cl::opt<bool> SmackOptions::WrappedIntegerEncoding(
     llvm::cl::desc(
         "Enable wrapped integer arithmetic and signedness-aware comparison"));
 
+const llvm::cl::list<std::string> SmackOptions::BplHeader(
+    "bpl-header", llvm::cl::ZeroOrMore,
+    llvm::cl::desc("Comment line at the top of the Boogie file"),
+    llvm::cl::value_desc("LINE"));
+
+const llvm::cl::opt<unsigned> SmackOptions::InlineBound(
+    "inline-bound",
+    llvm::cl::desc("Annotate procedures other than entry points to be inlined "
+                   "up to the given depth"),
+    llvm::cl::init(0));
+
+const llvm::cl::list<std::string> SmackOptions::InlinedProcedures(
+    "inline-procedures", llvm::cl::ZeroOrMore,
+    llvm::cl::desc("Annotate procedures whose names start with the given "
+                   "prefixes to be inlined"),
+    llvm::cl::value_desc("PREFIXES"));
+
+const llvm::cl::list<std::string> SmackOptions::SelectedAssertions(
+    "selected-assertions", llvm::cl::ZeroOrMore,
+    llvm::cl::desc("Keep only the assertions with the given attributes, e.g., "
+                   "valid_deref"),
+    llvm::cl::value_desc("ATTRS"));
+
 bool SmackOptions::isEntryPoint(llvm::StringRef name) {
   for (auto EP : EntryPoints)
     if (name == EP)
@@ -4,6 +4,7 @@
 #define DEBUG_TYPE "smack-rep"
 #include "smack/SmackRep.h"
 #include "smack/CodifyStaticInits.h"
+#include "smack/IntegerWrapElimination.h"
 #include "smack/SmackOptions.h"
 #include "smack/VectorOperations.h"
 
@@ -48,6 +49,29 @@ std::list<CallInst *> findCallers(Function *F) {
 
   return callers;
 }
+
+smack::BinExpr::Binary intPredicate(CmpInst::Predicate P) {
+  switch (P) {
+  case CmpInst::ICMP_EQ:
+    return smack::BinExpr::Eq;
+  case CmpInst::ICMP_NE:
+    return smack::BinExpr::Neq;
+  case CmpInst::ICMP_UGT:
+  case CmpInst::ICMP_SGT:
+    return smack::BinExpr::Gt;
+  case CmpInst::ICMP_UGE:
+  case CmpInst::ICMP_SGE:
+    return smack::BinExpr::Gte;
+  case CmpInst::ICMP_ULT:
+  case CmpInst::ICMP_SLT:
+    return smack::BinExpr::Lt;
+  case CmpInst::ICMP_ULE:
+  case CmpInst::ICMP_SLE:
+    return smack::BinExpr::Lte;
+  default:
+    llvm_unreachable("Unexpected integer predicate.");
+  }
+}
 } // namespace
 
 namespace smack {
@@ -624,6 +648,49 @@ const Expr *SmackRep::integerLit(long long v, unsigned width) {
   }
 }
 
+// This is heuristics for choosing between generating an unsigned vs
+// signed constant (since LLVM does not keep track of that).
+// Signed values -1 is special since it appears often because i--
+// gets translated into i + (-1), and so in that context it should
+// be a signed integer.
+bool SmackRep::isNegativeLit(const llvm::ConstantInt *ci, bool isUnsigned,
+                             bool isUnsignedInst) {
+  return ci->getBitWidth() > 1 &&
+         (isUnsigned ? (isUnsignedInst ? false : ci->isMinusOne())
+                     : ci->isNegative());
+}
+
+// Returns the flags (isUnsigned, isUnsignedInst) with which the constant
+// operands of an operation are translated, where isUnsigned is the choice of
+// the operation, e.g., the signedness of a comparison, unless the opcode
+// determines it.
+std::pair<bool, bool> SmackRep::litFlags(unsigned opcode, bool isUnsigned) {
+  switch (opcode) {
+  case Instruction::SDiv:
+  case Instruction::SRem:
+    return {false, false};
+  case Instruction::Sub:
+  case Instruction::UDiv:
+  case Instruction::URem:
+  case Instruction::Select:
+    return {true, true};
+  case Instruction::ICmp:
+  case Instruction::FCmp:
+    return {isUnsigned, true};
+  default:
+    return {isUnsigned, false};
+  }
+}
+
+std::pair<bool, bool> SmackRep::litFlags(const llvm::Instruction *I) {
+  if (auto CI = llvm::dyn_cast<CmpInst>(I))
+    return litFlags(I->getOpcode(), CI->isUnsigned());
+  return litFlags(I->getOpcode(),
+                  llvm::isa<BinaryOperator>(I) &&
+                      !(llvm::isa<OverflowingBinaryOperator>(I) &&
+                        I->hasNoSignedWrap()));
+}
+
 const Expr *SmackRep::lit(const llvm::Value *v, bool isUnsigned,
                           bool isUnsignedInst) {
   using namespace llvm;
@@ -631,15 +698,7 @@ const Expr *SmackRep::lit(const llvm::Value *v, bool isUnsigned,
   if (const ConstantInt *ci = llvm::dyn_cast<const ConstantInt>(v)) {
     const APInt &API = ci->getValue();
     unsigned width = ci->getBitWidth();
-
-    // This is heuristics for choosing between generating an unsigned vs
-    // signed constant (since LLVM does not keep track of that).
-    // Signed values -1 is special since it appears often because i--
-    // gets translated into i + (-1), and so in that context it should
-    // be a signed integer.
-    bool neg = width > 1 &&
-               (isUnsigned ? (isUnsignedInst ? false : API.getSExtValue() == -1)
-                           : ci->isNegative());
+    bool neg = isNegativeLit(ci, isUnsigned, isUnsignedInst);
     std::string str = (neg ? API.abs() : API).toString(10, false);
     const Expr *e =
         SmackOptions::BitPrecise ? Expr::lit(str, width) : Expr::lit(str, 0);
@@ -868,6 +927,9 @@ const Expr *SmackRep::expr(const llvm::Value *v, bool isConstIntUnsigned,
 }
 
 const Expr *SmackRep::cast(const llvm::Instruction *I) {
+  // the operand is already in the range of the destination type
+  if (IntegerWrapElimination::isMarked(*I))
+    return expr(I->getOperand(0));
   return cast(I->getOpcode(), I->getOperand(0), I->getType());
 }
 
@@ -916,6 +978,15 @@ const Expr *SmackRep::bop(const llvm::ConstantExpr *CE) {
 }
 
 const Expr *SmackRep::bop(const llvm::BinaryOperator *BO) {
+  // division without wrapping the operands, which are already in range
+  if (IntegerWrapElimination::isMarked(*BO)) {
+    auto flags = litFlags(BO);
+    return Expr::fn(
+        opName(BO->getOpcode() == Instruction::URem ? "$smod" : "$idiv",
+               {BO->getType()}),
+        expr(BO->getOperand(0), flags.first, flags.second),
+        expr(BO->getOperand(1), flags.first, flags.second));
+  }
   return bop(BO->getOpcode(), BO->getOperand(0), BO->getOperand(1),
              BO->getType(), !BO->hasNoSignedWrap());
 }
@@ -933,18 +1004,9 @@ const Expr *SmackRep::bop(unsigned opcode, const llvm::Value *lhs,
     }
   }
 
-  bool isUnsignedInst = false;
-  if (opcode == llvm::Instruction::SDiv || opcode == llvm::Instruction::SRem) {
-    isUnsigned = false;
-  } else if (opcode == llvm::Instruction::UDiv ||
-             opcode == llvm::Instruction::URem ||
-             opcode == llvm::Instruction::Sub) {
-    isUnsignedInst = true;
-    isUnsigned = true;
-  }
-
-  return Expr::fn(opName(fn, {t}), expr(lhs, isUnsigned, isUnsignedInst),
-                  expr(rhs, isUnsigned, isUnsignedInst));
+  auto flags = litFlags(opcode, isUnsigned);
+  return Expr::fn(opName(fn, {t}), expr(lhs, flags.first, flags.second),
+                  expr(rhs, flags.first, flags.second));
 }
 
 const Expr *SmackRep::uop(const llvm::ConstantExpr *CE) {
@@ -961,6 +1023,15 @@ const Expr *SmackRep::uop(const llvm::Value *op) {
 }
 
 const Expr *SmackRep::cmp(const llvm::CmpInst *I) {
+  // comparison without wrapping the operands, which are already in range
+  if (IntegerWrapElimination::isMarked(*I)) {
+    auto flags = litFlags(I);
+    const Expr *e1 = expr(I->getOperand(0), flags.first, flags.second);
+    const Expr *e2 = expr(I->getOperand(1), flags.first, flags.second);
+    return Expr::ifThenElse(
+        new BinExpr(intPredicate(I->getPredicate()), e1, e2),
+        integerLit(1ULL, 1), integerLit(0ULL, 1));
+  }
   return cmp(I->getPredicate(), I->getOperand(0), I->getOperand(1),
              I->isUnsigned());
 }
@@ -974,8 +1045,9 @@ const Expr *SmackRep::cmp(unsigned predicate, const llvm::Value *lhs,
                           const llvm::Value *rhs, bool isUnsigned) {
   std::string fn =
       opName(Naming::CMPINST_TABLE.at(predicate), {lhs->getType()});
-  const Expr *e1 = expr(lhs, isUnsigned, true);
-  const Expr *e2 = expr(rhs, isUnsigned, true);
+  auto flags = litFlags(Instruction::ICmp, isUnsigned);
+  const Expr *e1 = expr(lhs, flags.first, flags.second);
+  const Expr *e2 = expr(rhs, flags.first, flags.second);
   if (lhs->getType()->isFloatingPointTy())
     return Expr::ifThenElse(Expr::fn(fn + ".bool", e1, e2), integerLit(1ULL, 1),
                             integerLit(0ULL, 1));
@@ -995,14 +1067,28 @@ const Expr *SmackRep::select(const llvm::Value *condVal,
                              const llvm::Value *trueVal,
                              const llvm::Value *falseVal) {
   const Expr *c = expr(condVal);
-  const Expr *v1 = expr(trueVal, true, true);
-  const Expr *v2 = expr(falseVal, true, true);
+  auto flags = litFlags(Instruction::Select);
+  const Expr *v1 = expr(trueVal, flags.first, flags.second);
+  const Expr *v2 = expr(falseVal, flags.first, flags.second);
 
   assert(!condVal->getType()->isVectorTy() &&
          "Vector condition is not supported.");
   return Expr::ifThenElse(Expr::eq(c, integerLit(1LL, 1)), v1, v2);
 }
 
+const Expr *SmackRep::overflowPredicate(const llvm::CallInst &CI) {
+  // e.g., __SMACK_overflow.smul.i64 is translated to $smul.ovf.bv64
+  auto name = CI.getCalledFunction()->getName();
+  auto op = name.drop_front(Naming::OVERFLOW_PREDICATE.size() + 1)
+                .split('.')
+                .first;
+  assert(CI.getNumArgOperands() == 2 && "Expected binary overflow predicate.");
+  const llvm::Value *lhs = CI.getArgOperand(0);
+  const llvm::Value *rhs = CI.getArgOperand(1);
+  return Expr::fn(opName("$" + op.str() + ".ovf", {lhs->getType()}),
+                  expr(lhs), expr(rhs));
+}
+
 bool SmackRep::isContractExpr(const llvm::Value *V) const {
   auto name = naming->get(*V);
   return isContractExpr(name);
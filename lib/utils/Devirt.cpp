@@ -25,7 +25,10 @@ using namespace llvm;
 
 // Pass statistics
 STATISTIC(FuncAdded, "Number of bounce functions added");
+STATISTIC(FuncShared, "Number of call sites reusing a bounce function");
 STATISTIC(CSConvert, "Number of call sites converted");
+STATISTIC(TargetsFound, "Number of call targets before points-to refinement");
+STATISTIC(TargetsKept, "Number of call targets after points-to refinement");
 
 const bool SKIP_INCOMPLETE_NODES = false;
 
@@ -109,77 +112,69 @@ static inline bool match(CallBase *CS, const Function &F) {
   return true;
 }
 
-static inline bool checkArgs(const CallBase *CS, const Function *F) {
-  auto N = CS->arg_size();
-  auto T = F->getFunctionType();
-  auto M = T->getNumParams();
-
-  if (N + 1 != M)
-    return false;
-
-  for (unsigned i=0; i<N; i++) {
-    auto A = CS->getArgOperand(i);
-    auto PT = T->getParamType(i+1);
-    if (A->getType() != PT && !isZExtOrBitCastable(A, PT))
-      return false;
-  }
-  return true;
-}
-
 //
-// Method: findInCache()
+// Method: refineTargets()
 //
 // Description:
-//  This method looks through the cache of bounce functions to see if there
-//  exists a bounce function for the specified call site.
-//
-// Return value:
-//  0 - No usable bounce function has been created.
-//  Otherwise, a pointer to a bounce that can replace the call site is
-//  returned.
+//  Narrow the candidate targets of an indirect call site with the points-to
+//  information of its function pointer.  Function pointers which flow into
+//  the same pointer are unified into the same node, so a candidate whose node
+//  differs from the node of the called pointer cannot be called here.  Call
+//  sites whose pointer may come from unknown or external memory are left
+//  untouched.
 //
-const Function *
-Devirtualize::findInCache (const CallBase *CS,
-                           std::set<const Function*>& Targets) {
-  //
-  // Iterate through all of the existing bounce functions to see if one of them
-  // can be resued.
-  //
-  std::map<const Function *, std::set<const Function *> >::iterator I;
-  for (I = bounceCache.begin(); I != bounceCache.end(); ++I) {
-    //
-    // If the bounce function and the function pointer have different types,
-    // then skip this bounce function because it is incompatible.
-    //
-    const Function * bounceFunc = I->first;
-
-    // Check the return type
-    if (CS->getType() != bounceFunc->getReturnType())
-      continue;
+void
+Devirtualize::refineTargets (CallBase *CS,
+                             std::vector<const Function*>& Targets) {
+  const Function *Caller = CS->getFunction();
+  if (!DSA->hasGraph(*Caller))
+    return;
 
-    // Check the type of the function pointer and the argumentsa
-    PointerType* PT = dyn_cast<PointerType>(bounceFunc->arg_begin()->getType());
-    assert(PT);
-    if (CS->getCalledOperand()->stripPointerCastsAndAliases()->getType() != PT)
-      continue;
+  const seadsa::Graph &G = DSA->getGraph(*Caller);
+  const Value *FP = CS->getCalledOperand();
+  if (!G.hasCell(*FP))
+    return;
 
-    FunctionType* FT = dyn_cast<FunctionType>(PT->getElementType());
-    assert(FT);
-    if (FT->isVarArg() && !checkArgs(CS, bounceFunc))
-      continue;
+  const seadsa::Node *N = G.getCell(*FP).getNode();
+  if (!N || N->isIntToPtr() || N->isUnknown() || N->isExternal())
+    return;
 
-    //
-    // Determine whether the targets are identical.  If so, then this function
-    // can be used as a bounce function for this call site.
-    //
-    if (Targets == I->second)
-      return I->first;
-  }
+  std::vector<const Function*> Refined;
+  for (auto F : Targets)
+    if (!G.hasCell(*F) || G.getCell(*F).getNode() == N)
+      Refined.push_back(F);
 
   //
-  // No suiteable bounce function was found.
+  // An empty set means the analysis disagrees with the call graph; keep the
+  // original targets rather than making the call site unreachable.
   //
-  return 0;
+  if (!Refined.empty())
+    Targets.swap(Refined);
+}
+
+//
+// Method: getBounceType()
+//
+// Description:
+//  Compute the signature of the bounce function for the specified call site:
+//  the function pointer followed by the arguments of the call.  Pointer types
+//  are erased to void pointers, so that call sites which differ only in the
+//  pointee types of their operands share the same bounce function.
+//
+FunctionType *
+Devirtualize::getBounceType (CallBase *CS) {
+  auto erase = [](Type *T) -> Type * {
+    if (auto PT = dyn_cast<PointerType>(T))
+      if (PT->getAddressSpace() == 0)
+        return getVoidPtrType(T->getContext());
+    return T;
+  };
+
+  std::vector<Type *> TP;
+  TP.push_back (erase(CS->getCalledOperand()->getType()));
+  for (auto &A : CS->args())
+    TP.push_back (erase(A->getType()));
+  return FunctionType::get(CS->getType(), TP, false);
 }
 
 //
@@ -192,7 +187,8 @@ Devirtualize::findInCache (const CallBase *CS,
 //  matches.
 //
 Function*
-Devirtualize::buildBounce (CallBase *CS, std::vector<const Function*>& Targets) {
+Devirtualize::buildBounce (CallBase *CS, FunctionType *NewTy,
+                           std::vector<const Function*>& Targets) {
   //
   // Update the statistics on the number of bounce functions added to the
   // module.
@@ -204,16 +200,6 @@ Devirtualize::buildBounce (CallBase *CS, std::vector<const Function*>& Targets)
   // an additional pointer argument at the beginning of its argument list that
   // will be the function to call.
   //
-  Value* ptr = CS->getCalledOperand();
-  std::vector<Type *> TP;
-  TP.insert (TP.begin(), ptr->getType());
-  for (auto i = CS->arg_begin();
-       i != CS->arg_end();
-       ++i) {
-    TP.push_back ((*i)->getType());
-  }
-
-  FunctionType* NewTy = FunctionType::get(CS->getType(), TP, false);
   Module * M = CS->getParent()->getParent()->getParent();
   Function* F = Function::Create (NewTy,
                                   GlobalValue::InternalLinkage,
@@ -373,29 +359,40 @@ Devirtualize::makeDirectCall (CallBase *CS) {
         Targets.push_back(&F);
   }
 
+  TargetsFound += Targets.size();
+  NumTargetsFound += Targets.size();
+  refineTargets (CS, Targets);
+  TargetsKept += Targets.size();
+  NumTargetsKept += Targets.size();
+  SDEBUG(errs() << "devirt: " << Targets.size() << " target(s) for" << *CS
+                << "\n");
+
   //
   // Determine if an existing bounce function can be used for this call site.
   //
-  std::set<const Function *> targetSet (Targets.begin(), Targets.end());
-  const Function * NF = findInCache (CS, targetSet);
+  FunctionType *NewTy = getBounceType (CS);
+  BounceKey Key (NewTy, std::set<const Function *>(Targets.begin(),
+                                                   Targets.end()));
+  Function *&NF = bounceCache[Key];
 
   //
   // If no cached bounce function was found, build a function which will
   // implement a switch statement.  The switch statement will determine which
   // function target to call and call it.
   //
-  if (!NF) {
-    // Build the bounce function and add it to the cache
-    NF = buildBounce (CS, Targets);
-    bounceCache[NF] = targetSet;
-  }
+  if (!NF)
+    NF = buildBounce (CS, NewTy, Targets);
+  else
+    ++FuncShared;
 
   //
   // Replace the original call with a call to the bounce function.
   //
   if (CallInst* CI = dyn_cast<CallInst>(CS)) {
     std::vector<Value*> Params;
-    Params.push_back(CI->getCalledOperand());
+    Params.push_back(
+      castTo(CI->getCalledOperand(), NF->getFunctionType()->getParamType(0), "", CS)
+    );
     for (unsigned i=0; i<CI->getNumArgOperands(); i++) {
       Params.push_back(
         castTo(CI->getArgOperand(i), NF->getFunctionType()->getParamType(i+1), "", CS)
@@ -403,7 +400,7 @@ Devirtualize::makeDirectCall (CallBase *CS) {
     }
 
     std::string name = CI->hasName() ? CI->getName().str() + ".dv" : "";
-    CallInst* CN = CallInst::Create (const_cast<Function*>(NF),
+    CallInst* CN = CallInst::Create (NF,
                                        Params,
                                        name,
                                        CI);
@@ -411,13 +408,15 @@ Devirtualize::makeDirectCall (CallBase *CS) {
     CI->eraseFromParent();
   } else if (InvokeInst* CI = dyn_cast<InvokeInst>(CS)) {
     std::vector<Value*> Params;
-    Params.push_back(CI->getCalledOperand());
+    Params.push_back(
+      castTo(CI->getCalledOperand(), NF->getFunctionType()->getParamType(0), "", CS)
+    );
     for (unsigned i=0; i<CI->getNumArgOperands(); i++)
       Params.push_back(
         castTo(CI->getArgOperand(i), NF->getFunctionType()->getParamType(i+1), "", CS)
       );
     std::string name = CI->hasName() ? CI->getName().str() + ".dv" : "";
-    InvokeInst* CN = InvokeInst::Create(const_cast<Function*>(NF),
+    InvokeInst* CN = InvokeInst::Create(NF,
                                         CI->getNormalDest(),
                                         CI->getUnwindDest(),
                                         Params,
@@ -478,6 +477,7 @@ Devirtualize::runOnModule (Module & M) {
   // Get the targets of indirect function calls.
   //
   CCG = &getAnalysis<seadsa::CompleteCallGraph>();
+  DSA = &getAnalysis<seadsa::DsaAnalysis>().getDsaAnalysis();
 
   //
   // Get information on the target system.
@@ -499,6 +499,14 @@ Devirtualize::runOnModule (Module & M) {
     makeDirectCall (Worklist[index]);
   }
 
+  if (!Worklist.empty())
+    SDEBUG(errs() << "devirt: average dispatch width "
+                  << (double) NumTargetsFound / Worklist.size() << " before and "
+                  << (double) NumTargetsKept / Worklist.size()
+                  << " after points-to refinement, " << bounceCache.size()
+                  << " bounce function(s) for " << Worklist.size()
+                  << " call site(s)\n");
+
   //
   // Conservatively assume that we've changed one or more call sites.
   //
@@ -512,4 +520,5 @@ using namespace seadsa;
 // Pass registration
 INITIALIZE_PASS_BEGIN(Devirtualize, "devirt", "Devirtualize indirect function calls", false, false)
 INITIALIZE_PASS_DEPENDENCY(CompleteCallGraph)
+INITIALIZE_PASS_DEPENDENCY(DsaAnalysis)
 INITIALIZE_PASS_END(Devirtualize, "devirt", "Devirtualize indirect function calls", false, false)
@@ -0,0 +1,188 @@
+import hashlib
+import json
+import os
+import re
+import shutil
+from threading import Lock
+
+# The placeholder for the path of the Boogie source file in cached outputs,
+# since identical programs may be verified under different names.
+BPL_FILE = '@BPL_FILE@'
+
+
+# The paths of assemblies in the scripts which launch verifiers.
+ASSEMBLY = re.compile(r'[^\s\'"]+\.(?:dll|exe)\b')
+
+binaries = {}
+
+
+def file_identity(path):
+    st = os.stat(path)
+    return '%s:%d:%d' % (path, st.st_size, st.st_mtime_ns)
+
+
+def launched_files(path):
+    '''The files which the executable PATH runs: the .dll or .exe files named
+    by a script, e.g., mono or dotnet wrappers, and the assemblies of a .NET
+    tool installed with --tool-path, whose launcher is the same for every
+    version.'''
+    files = []
+    with open(path, 'rb') as f:
+        text = f.read(1 << 16)
+    if text.startswith(b'#!'):
+        for m in ASSEMBLY.finditer(text.decode(errors='replace')):
+            # Paths relative to the script follow a substitution, e.g.,
+            # $(dirname $0)/../bin/Release/tool.exe.
+            name = re.sub(r'^.*[)}]/?', '', m.group())
+            if not os.path.isabs(name):
+                name = os.path.join(os.path.dirname(path), name)
+            if os.path.isfile(name):
+                files.append(os.path.realpath(name))
+    store = os.path.join(os.path.dirname(path), '.store',
+                         os.path.basename(path).lower())
+    for root, dirs, names in os.walk(store):
+        dirs.sort()
+        files += [os.path.join(root, n) for n in sorted(names)
+                  if n.endswith('.dll')]
+    return files
+
+
+def binary_identity(name):
+    '''Identify the binary NAME by the resolved paths, sizes, and times of
+    modification of its executable and the files it launches, which change
+    with its version.'''
+    if name not in binaries:
+        path = shutil.which(name)
+        if path:
+            path = os.path.realpath(path)
+            binaries[name] = '\0'.join(
+                file_identity(p) for p in [path] + launched_files(path))
+        else:
+            binaries[name] = name
+    return binaries[name]
+
+
+def update_with_file(h, path):
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 20), b''):
+            h.update(chunk)
+
+
+def command_key(command, sources):
+    '''The key of the output of COMMAND on the files SOURCES, e.g., of a
+    compiler on a source file and the headers it includes.'''
+    h = hashlib.sha256(binary_identity(command[0]).encode())
+    for arg in command[1:]:
+        h.update(b'\0' + arg.encode())
+    for source in sources:
+        h.update(b'\0' + source.encode() + b'\0')
+        update_with_file(h, source)
+    return h.hexdigest()
+
+
+def link_or_copy(source, target):
+    '''Replace TARGET by a hard link to SOURCE, or by a copy of SOURCE on
+    another file system, so that TARGET outlives SOURCE.'''
+    tmp = '%s.%d.tmp' % (target, os.getpid())
+    try:
+        os.link(source, tmp)
+    except OSError:
+        shutil.copyfile(source, tmp)
+    os.replace(tmp, target)
+
+
+def default_cache_dir():
+    base = os.environ.get('XDG_CACHE_HOME',
+                          os.path.join(os.path.expanduser('~'), '.cache'))
+    return os.path.join(base, 'smack')
+
+
+class ResultCache:
+    '''A content-addressed cache of verification results, bounded in size.
+
+    The key of a verification job is the hash of the Boogie source file, the
+    verifier command line, and the identities of the verifier and the solver.
+    Its entry records the result and the verifier output, from which the error
+    trace and the JSON output are derived. Only definitive results are cached,
+    and the least recently used entries are evicted first. The entries live in
+    the results subdirectory of the cache directory, and other contents of the
+    cache directory, e.g., library bitcode, are never evicted.
+    '''
+
+    def __init__(self, directory, max_size):
+        self.directory = os.path.join(directory, 'results')
+        self.max_size = max_size
+        self.lock = Lock()
+        self.hits = 0
+        self.misses = 0
+
+    def key(self, bpl_file, command, tools=()):
+        '''The key of the verification of BPL_FILE with COMMAND, which runs
+        the binaries TOOLS, e.g., the solver, besides its executable.'''
+        h = hashlib.sha256()
+        update_with_file(h, bpl_file)
+        for tool in [command[0]] + list(tools):
+            h.update(b'\0' + binary_identity(tool).encode())
+        for arg in command[1:]:
+            h.update(b'\0' + arg.replace(bpl_file, BPL_FILE).encode())
+        return h.hexdigest()
+
+    def path(self, key):
+        return os.path.join(self.directory, key[:2], key + '.json')
+
+    def lookup(self, key, bpl_file):
+        '''Return the cached result name and verifier output for KEY, or
+        None.'''
+        path = self.path(key)
+        try:
+            with open(path, 'r') as f:
+                entry = json.load(f)
+            os.utime(path)
+        except (OSError, ValueError):
+            with self.lock:
+                self.misses += 1
+            return None
+        with self.lock:
+            self.hits += 1
+        return entry['result'], entry['output'].replace(BPL_FILE, bpl_file)
+
+    def store(self, key, bpl_file, result, output):
+        path = self.path(key)
+        try:
+            os.makedirs(os.path.dirname(path), exist_ok=True)
+            tmp = '%s.%d.tmp' % (path, os.getpid())
+            with open(tmp, 'w') as f:
+                json.dump({'result': result,
+                           'output': output.replace(bpl_file, BPL_FILE)}, f)
+            os.replace(tmp, path)
+            self.evict()
+        except OSError:
+            pass
+
+    def evict(self):
+        '''Remove the least recently used entries until the cache fits.'''
+        with self.lock:
+            entries = []
+            for root, _, files in os.walk(self.directory):
+                for name in files:
+                    if not name.endswith('.json'):
+                        continue
+                    path = os.path.join(root, name)
+                    try:
+                        st = os.stat(path)
+                    except OSError:
+                        continue
+                    entries.append((st.st_mtime, st.st_size, path))
+            size = sum(e[1] for e in entries)
+            for _, entry_size, path in sorted(entries):
+                if size <= self.max_size:
+                    break
+                try:
+                    os.unlink(path)
+                except OSError:
+                    pass
+                size -= entry_size
+
+    def summary(self):
+        return 'verification cache: %d hits, %d misses' % (self.hits,
+                                                           self.misses)
@@ -63,8 +63,11 @@ def error_trace(verifier_output, verifier):
     return output
 
 
-def json_output_str(result, output, verifier, prettify=True):
-    return json.dumps(json_output(result, output, verifier, prettify))
+def json_output_str(result, output, verifier, prettify=True, extra=None):
+    data = json_output(result, output, verifier, prettify)
+    if extra:
+        data = dict(data or {}, **extra)
+    return json.dumps(data)
 
 
 def json_output(result, output, verifier, prettify=True):
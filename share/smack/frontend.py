@@ -2,8 +2,11 @@ import os
 import sys
 import re
 import json
+import shutil
+import time
+from .cache import command_key, link_or_copy
 from .utils import temporary_file, try_command, temporary_directory,\
-    llvm_exact_bin
+    llvm_exact_bin, run_parallel
 from .versions import RUST_VERSION
 
 # Needed for cargo operations
@@ -133,6 +136,8 @@ def default_clang_compile_command(args, lib=False):
         cmd += ['-DFLOAT_ENABLED']
     if args.pthread:
         cmd += ['-DSMACK_MAX_THREADS=' + str(args.max_threads)]
+    if args.lazy_sequentialization:
+        cmd += ['-DSMACK_SEQUENTIALIZE']
     if args.integer_encoding == 'bit-vector':
         cmd += ['-DBIT_PRECISE']
     if sys.stdout.isatty():
@@ -140,14 +145,66 @@ def default_clang_compile_command(args, lib=False):
     return cmd
 
 
+def report_compile_time(input_file, start, args):
+    if args.verbose and not args.quiet:
+        print("Compiled %s in %.2fs" % (input_file, time.time() - start))
+
+
 def compile_to_bc(input_file, compile_command, args):
     """Compile a source file to LLVM IR."""
+    start = time.time()
     bc = temporary_file(
         os.path.splitext(
             os.path.basename(input_file))[0],
         '.bc',
         args)
     try_command(compile_command + ['-o', bc, input_file], console=True)
+    report_compile_time(input_file, start, args)
+    return bc
+
+
+def smack_lib_sources(input_file):
+    """The files whose contents determine the bitcode of a SMACK library."""
+    sources = [input_file]
+    for root, dirs, files in os.walk(smack_header_path()):
+        dirs.sort()
+        sources += [os.path.join(root, f) for f in sorted(files)]
+    return sources
+
+
+def compile_lib_to_bc(input_file, compile_command, args):
+    """Compile a SMACK library source file to LLVM IR, unless a previous run
+    has compiled the same sources with the same command."""
+
+    if args.no_cache:
+        return compile_to_bc(input_file, compile_command, args)
+
+    from .top import VERSION
+
+    command = [c for c in compile_command if c != '-fcolor-diagnostics']
+    key = command_key(command, smack_lib_sources(input_file))
+    name = os.path.splitext(os.path.basename(input_file))[0]
+    cached = os.path.join(args.cache_dir, 'lib', VERSION,
+                          '%s-%s.bc' % (name, key))
+    # A private link to the cached bitcode, which another process may
+    # replace meanwhile.
+    if os.path.isfile(cached):
+        bc = temporary_file(name, '.bc', args)
+        try:
+            link_or_copy(cached, bc)
+            os.utime(cached)
+            return bc
+        except OSError:
+            pass
+
+    bc = compile_to_bc(input_file, compile_command, args)
+    try:
+        os.makedirs(os.path.dirname(cached), exist_ok=True)
+        tmp = '%s.%d.tmp' % (cached, os.getpid())
+        shutil.copyfile(bc, tmp)
+        os.replace(tmp, cached)
+    except OSError:
+        pass
     return bc
 
 
@@ -283,29 +340,38 @@ def json_compilation_database_frontend(input_file, args):
     output_flags = re.compile(r"-o ([^ ]*)[.]o\b")
     optimization_flags = re.compile(r"-O[1-9]\b")
 
+    def compile_unit(cc):
+        start = time.time()
+        command = cc['command']
+        command = output_flags.sub(r"-o \1.bc", command)
+        command = optimization_flags.sub("-O0", command)
+        command = command + " -emit-llvm"
+        try_command(command.split(), cc['directory'], console=True)
+        report_compile_time(cc.get('file', command), start, args)
+
     with open(input_file) as f:
-        for cc in json.load(f):
-            if 'objects' in cc:
-                # TODO what to do when there are multiple linkings?
-                bit_codes = [re.sub('[.]o$', '.bc', f) for f in cc['objects']]
-                try_command([
-                             llvm_exact_bin('llvm-link'),
-                             '-o',
-                             args.bc_file
-                            ] + bit_codes)
-                try_command([
-                             llvm_exact_bin('llvm-link'),
-                             '-o',
-                             args.linked_bc_file,
-                             args.bc_file
-                            ] + default_build_libs(args))
-
-            else:
-                command = cc['command']
-                command = output_flags.sub(r"-o \1.bc", command)
-                command = optimization_flags.sub("-O0", command)
-                command = command + " -emit-llvm"
-                try_command(command.split(), cc['directory'], console=True)
+        database = json.load(f)
+
+    # The translation units are independent, and linked once all compiled.
+    run_parallel(compile_unit, [cc for cc in database if 'objects' not in cc],
+                 args.jobs)
+
+    for cc in database:
+        if 'objects' in cc:
+            # TODO what to do when there are multiple linkings?
+            bit_codes = [re.sub('[.]o$', '.bc', f) for f in cc['objects']]
+            try_command([
+                         llvm_exact_bin('llvm-link'),
+                         '-o',
+                         args.bc_file
+                        ] + bit_codes)
+            try_command([
+                         llvm_exact_bin('llvm-link'),
+                         '-o',
+                         args.linked_bc_file,
+                         args.bc_file
+                        ] + default_build_libs(args))
+
     # import here to avoid a circular import
     from .top import llvm_to_bpl
     llvm_to_bpl(args)
@@ -409,7 +475,6 @@ def rust_frontend(input_file, args):
 
 def default_build_libs(args):
     """Generate LLVM bitcodes for SMACK libraries."""
-    bitcodes = []
     libs = ['smack.c', 'stdlib.c', 'errno.c', 'smack-rust.c']
 
     if args.pthread:
@@ -423,11 +488,9 @@ def default_build_libs(args):
         libs += ['fenv.c']
 
     compile_command = default_clang_compile_command(args, True)
-    for c in [os.path.join(smack_lib(), c) for c in libs]:
-        bc = compile_to_bc(c, compile_command, args)
-        bitcodes.append(bc)
-
-    return bitcodes
+    return run_parallel(
+        lambda c: compile_lib_to_bc(c, compile_command, args),
+        [os.path.join(smack_lib(), c) for c in libs], args.jobs)
 
 
 def fortran_build_libs(args):
@@ -456,7 +519,7 @@ def cplusplus_build_libs(args):
     compile_command[0] = llvm_exact_bin('clang++')
 
     for c in [os.path.join(smack_lib(), c) for c in libs]:
-        bc = compile_to_bc(c, compile_command, args)
+        bc = compile_lib_to_bc(c, compile_command, args)
         bitcodes.append(bc)
 
     return bitcodes
@@ -471,7 +534,7 @@ def rust_build_libs(args):
         ['--emit=llvm-bc', '--crate-type', 'lib'])
 
     for c in [os.path.join(smack_lib(), c) for c in libs]:
-        bc = compile_to_bc(c, compile_command, args)
+        bc = compile_lib_to_bc(c, compile_command, args)
         bitcodes.append(bc)
 
     return bitcodes
@@ -487,9 +550,16 @@ def link_bc_files(bitcodes, libs, args):
         smack_libs += build_lib(args)
 
     bitcodes = extern_entry_points(args, bitcodes)
-    try_command([llvm_exact_bin('llvm-link'), '-o', args.bc_file] + bitcodes)
-    try_command([llvm_exact_bin('llvm-link'), '-o', args.linked_bc_file,
-                 args.bc_file] + smack_libs)
+    if args.save_bc:
+        try_command([llvm_exact_bin('llvm-link'), '-o', args.bc_file]
+                    + bitcodes)
+        bitcodes = [args.bc_file]
+    if args.save_linked_bc:
+        try_command([llvm_exact_bin('llvm-link'), '-o', args.linked_bc_file]
+                    + bitcodes + smack_libs)
+        args.translated_bc_files = [args.linked_bc_file]
+    else:
+        args.translated_bc_files = bitcodes + smack_libs
 
     # import here to avoid a circular import
     from .top import llvm_to_bpl
@@ -7,6 +7,36 @@
 
 void *__SMACK_PthreadReturn[SMACK_MAX_THREADS];
 
+#ifdef SMACK_SEQUENTIALIZE
+// Thread state of the lazily-sequentialized program. Thread 0 is unused, so
+// that no thread ID coincides with UNLOCKED; the main thread is thread 1.
+// The LazySequentialization pass schedules the active threads, and resumes
+// each thread at its program counter.
+int __SMACK_thread_count = 2;
+int __SMACK_current_thread = 1;
+int __SMACK_thread_active[SMACK_MAX_THREADS] = {0, 1};
+int __SMACK_thread_done[SMACK_MAX_THREADS];
+int __SMACK_thread_pc[SMACK_MAX_THREADS];
+void *(*__SMACK_thread_routine[SMACK_MAX_THREADS])(void *);
+void *__SMACK_thread_arg[SMACK_MAX_THREADS];
+
+// Library functions execute atomically, as context switches only happen in
+// the code of thread functions.
+#define ATOMIC_BEGIN
+#define ATOMIC_END
+
+void __SMACK_thread_return(void *retval) {
+  __SMACK_PthreadReturn[__SMACK_current_thread] = retval;
+  __SMACK_thread_active[__SMACK_current_thread] = 0;
+  __SMACK_thread_done[__SMACK_current_thread] = 1;
+}
+
+pthread_t pthread_self(void) { return __SMACK_current_thread; }
+
+#else
+#define ATOMIC_BEGIN __SMACK_code("call corral_atomic_begin();")
+#define ATOMIC_END __SMACK_code("call corral_atomic_end();")
+
 void __SMACK_init_tidtype() {
 #ifdef BIT_PRECISE
   __SMACK_top_decl("type $tidtype = bv32;");
@@ -44,6 +74,7 @@ pthread_t pthread_self(void) {
 
   return actual_tid;
 }
+#endif
 
 int pthread_equal(pthread_t t1, pthread_t t2) {
   // Return non-zero if threads are equal.  0 otherwise.
@@ -61,7 +92,11 @@ int pthread_join(pthread_t __th, void **__thread_return) {
     return 35; // This is EDEADLK
 
   // Wait for the thread to terminate
+#ifdef SMACK_SEQUENTIALIZE
+  __VERIFIER_assume(__SMACK_thread_done[__th]);
+#else
   __SMACK_code("assume $pthreadStatus[@] == $pthread_stopped;", __th);
+#endif
 
   if (__thread_return) {
     *__thread_return = __SMACK_PthreadReturn[__th];
@@ -80,6 +115,10 @@ int pthread_join(pthread_t __th, void **__thread_return) {
 //       In other words, a `return` should pass its value to an implicit call to
 //       pthread_exit().
 void pthread_exit(void *retval) {
+#ifdef SMACK_SEQUENTIALIZE
+  // The sequentialized thread function returns after this call
+  __SMACK_thread_return(retval);
+#else
   pthread_t tid = pthread_self();
 
 // Ensure exit hasn't already been called
@@ -90,6 +129,7 @@ void pthread_exit(void *retval) {
 
   // Set return pointer value for display in SMACK traces
   void *pthread_return_pointer = retval;
+#endif
 }
 
 int pthread_mutexattr_init(pthread_mutexattr_t *attr) {
@@ -138,11 +178,11 @@ int pthread_mutex_lock(pthread_mutex_t *__mutex) {
     assert(0);
 #endif
   }
-  __SMACK_code("call corral_atomic_begin();");
+  ATOMIC_BEGIN;
   // Wait for lock to become free
   __VERIFIER_assume(__mutex->lock == UNLOCKED);
   __mutex->lock = tid;
-  __SMACK_code("call corral_atomic_end();");
+  ATOMIC_END;
   return 0;
 }
 
@@ -165,9 +205,9 @@ int pthread_mutex_unlock(pthread_mutex_t *__mutex) {
     assert(0);
 #endif
   }
-  __SMACK_code("call corral_atomic_begin();");
+  ATOMIC_BEGIN;
   __mutex->lock = UNLOCKED;
-  __SMACK_code("call corral_atomic_end();");
+  ATOMIC_END;
   return 0;
 }
 
@@ -177,9 +217,9 @@ int pthread_mutex_destroy(pthread_mutex_t *__mutex) {
   assert(__mutex->init == INITIALIZED);
   assert(__mutex->lock == UNLOCKED);
 #endif
-  __SMACK_code("call corral_atomic_begin();");
+  ATOMIC_BEGIN;
   __mutex->init = UNINITIALIZED;
-  __SMACK_code("call corral_atomic_end();");
+  ATOMIC_END;
   return 0;
 }
 
@@ -213,7 +253,10 @@ int pthread_cond_wait(pthread_cond_t *__cond, pthread_mutex_t *__mutex) {
 
   // assume(__cond->cond == 1);
   //__cond->cond = 0;
+#ifndef SMACK_SEQUENTIALIZE
+  // The sequentialized caller re-acquires the mutex after a context switch
   pthread_mutex_lock(__mutex);
+#endif
   return 0;
 }
 
@@ -251,6 +294,18 @@ int pthread_cond_destroy(pthread_cond_t *__cond) {
   return 0;
 }
 
+#ifdef SMACK_SEQUENTIALIZE
+int pthread_create(pthread_t *__newthread, __const pthread_attr_t *__attr,
+                   void *(*__start_routine)(void *), void *__arg) {
+  int tid = __SMACK_thread_count++;
+  __VERIFIER_assume(tid < SMACK_MAX_THREADS);
+  __SMACK_thread_routine[tid] = __start_routine;
+  __SMACK_thread_arg[tid] = __arg;
+  __SMACK_thread_active[tid] = 1;
+  *__newthread = tid;
+  return 0;
+}
+#else
 void __call_wrapper(pthread_t *__newthread, void *(*__start_routine)(void *),
                     void *__arg) {
 
@@ -285,3 +340,4 @@ int pthread_create(pthread_t *__newthread, __const pthread_attr_t *__attr,
 
   return 0;
 }
+#endif
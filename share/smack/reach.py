@@ -4,18 +4,34 @@
 #
 
 import argparse
+import copy
 import re
 import pprint
-import subprocess
 import json
-from smackgen import *
-from smackverify import *
-
-VERSION = '2.8.0'
+import os
+import sys
+from threading import Lock
+from . import top
+from .frontend import default_clang_compile_command
+from .utils import derived_file, run_parallel, try_command, remove_temp_files
 
 
 def reachParser():
-    parser = argparse.ArgumentParser(add_help=False, parents=[verifyParser()])
+    parser = argparse.ArgumentParser(add_help=False)
+
+    parser.add_argument('--smackd', action='store_true', default=False,
+                        help='print the unreachable lines in JSON format')
+
+    parser.add_argument('--batch-size', dest='batchSize', metavar='N',
+                        default=0, type=int,
+                        help='instrument N source lines per verifier run, '
+                        'and report up to N counterexamples per run '
+                        '(corral only) [default: one line per run]')
+
+    parser.add_argument('--batch-jobs', dest='batchJobs', metavar='N',
+                        default=os.cpu_count() or 1, type=int,
+                        help='run up to N batches in parallel '
+                        '[default: number of CPUs]')
 
     return parser
 
@@ -66,7 +82,7 @@ def GetSourceLineInfo(bplFile):
     return sorted(sourceInfo, key=lambda e: e['sourceLineNo'], reverse=True)
 
 
-def UpdateWithClangInfo(clangOuptut, sourceInfo):
+def UpdateWithClangInfo(clangOutput, sourceInfo):
     FILENAME = r'[\w#$~%.\/-]+'
     regex = ('('
              + FILENAME
@@ -87,30 +103,23 @@ def UpdateWithClangInfo(clangOuptut, sourceInfo):
             sourceInfo.append(newSource)
 
 
-def GetCodeCoverage(
-        verifier,
-        bplFileName,
-        timeLimit,
-        unroll,
-        contextSwitches,
-        debug,
-        smackd,
-        clangOutput):
-    sourceInfo = GetSourceLineInfo(bplFileName)
+def GetCodeCoverage(args, clangOutput, smackd, batchSize=0, batchJobs=1):
+    sourceInfo = GetSourceLineInfo(args.bpl_file)
 
-    for sourceLine in sourceInfo:
-        if(not sourceLine['isReachable']):
-            reachRes = TestReachability(
-                verifier,
-                bplFileName,
-                timeLimit,
-                unroll,
-                contextSwitches,
-                debug,
-                sourceLine)
+    decided = set()
+    if(batchSize > 1 and args.verifier == 'corral'):
+        decided = GetBatchedReachability(
+            args,
+            sourceInfo,
+            batchSize,
+            batchJobs)
+
+    for i, sourceLine in enumerate(sourceInfo):
+        if(not sourceLine['isReachable'] and i not in decided):
+            reachRes = TestReachability(args, sourceLine)
 
             # TODO - how does python handle changing lists in for loop?
-            UpdateSourceInfo(reachRes, sourceInfo, verifier)
+            UpdateSourceInfo(reachRes, sourceInfo, args.verifier)
 
     # Add lines caught by clang's -Wunreachable-code
     UpdateWithClangInfo(clangOutput, sourceInfo)
@@ -139,41 +148,96 @@ def GetCodeCoverage(
     if(smackd):
         print((json.dumps(result)))
     else:
-        print('\nSMACK verifier version ' + VERSION + '\n\n')
+        print('\nSMACK verifier version ' + top.VERSION + '\n\n')
         print("Unreachable code:")
         pprint.pprint(result, width=100)
 
 
-def TestReachability(
-        verifier,
-        bplFileName,
-        timeLimit,
-        unroll,
-        contextSwitches,
-        debug,
-        lineInfo):
+def TestReachability(args, lineInfo):
     boogieText = "assert false;"
 
-    bplfileBase = path.splitext(bplFileName)[0]
-    bplNew = bplfileBase + "_coverage.bpl"
+    bplNew = derived_file(args.bpl_file, 'coverage', args)
 
     CopyFileWhileInserting(
-        bplFileName,
+        args.bpl_file,
         bplNew,
         lineInfo['bplLineNo'] + 1,
         boogieText)
 
-    # do not pass smackd flag as true.  Breaks parsing
-    corralOutput = verify(
-        verifier,
-        bplNew,
-        timeLimit,
-        unroll,
-        contextSwitches,
-        debug,
-        False)
+    return RunVerifier(args, bplNew, 1)[1]
+
+
+# Each batch instruments its lines with assertions tagged by their index in
+# sourceInfo. An assertion of false ends each trace which reaches it, so the
+# batch is verified again without the assertions reached, as long as a run
+# reaches new lines; the lines left after a run which reaches none, and does
+# not time out, are unreachable. Returns the indices of the lines decided,
+# i.e., all but those of batches which timed out.
+
+
+def GetBatchedReachability(args, sourceInfo, batchSize, batchJobs):
+    candidates = [i for i, e in enumerate(sourceInfo)
+                  if e['bplLineNo'] >= 0 and not e['isReachable']]
+    batches = [candidates[i:i + batchSize]
+               for i in range(0, len(candidates), batchSize)]
+    lock = Lock()
+    decided = set()
+
+    def runBatch(number):
+        batch = batches[number]
+        bplNew = derived_file(args.bpl_file, 'coverage%d' % number, args)
+        while batch:
+            CopyFileWhileTagging(args.bpl_file, bplNew, sourceInfo, batch)
+            result, corralOutput = RunVerifier(args, bplNew, len(batch))
+            if(result is top.VResult.TIMEOUT):
+                return
+
+            tags = [tag for tag in ReachedTags(corralOutput) if tag in batch]
+            with lock:
+                for tag in tags:
+                    sourceInfo[tag]['isReachable'] = True
+                UpdateSourceInfo(corralOutput, sourceInfo, 'corral')
+                left = [i for i in batch if not sourceInfo[i]['isReachable']]
+                if(len(left) == len(batch)):
+                    decided.update(batch)
+                    return
+                batch = left
+
+    run_parallel(runBatch, range(len(batches)), batchJobs)
+
+    return decided
+
+
+def CopyFileWhileTagging(srcFile, dstFile, sourceInfo, batch):
+    inFile = open(srcFile, "r")
+    inContents = inFile.readlines()
+    inFile.close()
+
+    # Insert bottom-up, so that the line numbers of the others stay valid
+    for tag in sorted(batch, key=lambda i: sourceInfo[i]['bplLineNo'],
+                      reverse=True):
+        inContents.insert(sourceInfo[tag]['bplLineNo'] + 1,
+                          "assert {:reach %d} false;\n" % tag)
+
+    outFile = open(dstFile, "w")
+    outFile.write("".join(inContents))
+    outFile.close()
+
 
-    return corralOutput
+# Runs the verifier of ARGS on another Boogie file, reporting up to MAXCEX
+# counterexamples, and returns its result and output.
+
+
+def RunVerifier(args, bplFileName, maxCex):
+    verifierArgs = copy.copy(args)
+    verifierArgs.bpl_file = bplFileName
+    verifierArgs.max_violations = maxCex
+    return top.run_verifier(verifierArgs)
+
+
+def ReachedTags(corralOutput):
+    return [int(tag) for tag in
+            re.findall(r'assert {:reach (\d+)} false', corralOutput)]
 
 
 def UpdateSourceInfo(corralOutput, sourceInfo, verifier):
@@ -213,44 +277,43 @@ def UpdateSourceInfo(corralOutput, sourceInfo, verifier):
                     sourceLine['isReachable'] = True
 
 
+# Lines which clang finds unreachable are optimized away before SMACK sees
+# them, so they are collected from its -Wunreachable-code warnings.
+
+
+def UnreachableCodeWarnings(args):
+    sources = [f for f in args.input_files
+               if os.path.splitext(f)[1] in ['.c', '.i']]
+    if(not sources):
+        return ''
+    return try_command(default_clang_compile_command(args)
+                       + ['-fsyntax-only', '-Wunreachable-code'] + sources)
+
+
 def main():
-    parser = argparse.ArgumentParser(
-        description='Checks the input LLVM file for code reachability.',
-        parents=[
-            reachParser()])
-    parser.parse_args()  # just check if arguments are looking good
-
-    # !!!!!!START COPY OF SECTION FROM smackverify.py!!!!!!!!!!!
-    #  Probably should pull into subroutine or something
-    # remove arguments not recognized by lower scripts
-    # not sure of a better way to do this
-    sysArgv = sys.argv[:]
-    for i in reversed(list(range(len(sysArgv)))):
-        if sysArgv[i] == '--smackd':
-            del sysArgv[i]
-        elif sys.argv[i] == '--time-limit':
-            del sysArgv[i]
-            del sysArgv[i]
-        elif sys.argv[i] == '--context-bound':
-            del sysArgv[i]
-            del sysArgv[i]
-
-    # Add clang's -Wunreachable-code flag
-    sysArgv.append('--clang=-Wunreachable-code')
-    bpl, options, clangOutput = smackGenerate(sysArgv)
-    args = parser.parse_args(options + sys.argv[1:])
-
-    # write final output
-    args.outfile.write(bpl)
-    args.outfile.close()
-    # !!!!!!END COPY OF SECTION FROM smackverify.py!!!!!!!!!!!
-
-    GetCodeCoverage(
-        args.verifier,
-        args.outfile.name,
-        args.timeLimit,
-        args.unroll,
-        args.contextSwitches,
-        args.debug,
-        args.smackd,
-        clangOutput)
+    # The remaining arguments are those of smack, which translates the input
+    # files, and whose verifier options apply to every reachability check.
+    reachArgs, smackArgv = reachParser().parse_known_args()
+    sys.argv = sys.argv[:1] + smackArgv
+
+    try:
+        top.args = args = top.arguments()
+        if(reachArgs.smackd):
+            args.quiet = True
+
+        top.target_selection(args)
+        clangOutput = UnreachableCodeWarnings(args)
+        top.frontend(args)
+
+        GetCodeCoverage(
+            args,
+            clangOutput,
+            reachArgs.smackd,
+            reachArgs.batchSize,
+            reachArgs.batchJobs)
+
+    except KeyboardInterrupt:
+        sys.exit("SMACK aborted by keyboard interrupt.")
+
+    finally:
+        remove_temp_files()
@@ -3,6 +3,7 @@ import re
 import sys
 import subprocess
 import time
+import copy
 from shutil import copyfile
 import smack.top
 import smack.frontend
@@ -69,6 +70,12 @@ def force_timeout():
   sys.stdout.flush()
   time.sleep(1000)
 
+def needs_assert_false(args):
+  from smack.top import VProperty
+  return not (VProperty.MEMORY_SAFETY in args.check
+              or VProperty.MEMLEAK in args.check
+              or VProperty.INTEGER_OVERFLOW in args.check)
+
 def inject_assert_false(args):
   with open(args.bpl_file, 'r') as bf:
     content = bf.read()
@@ -76,86 +83,290 @@ def inject_assert_false(args):
   with open(args.bpl_file, 'w') as bf:
     bf.write(content)
 
-def verify_bpl_svcomp(args):
-  """Verify the Boogie source file using SVCOMP-tuned heuristics."""
-  heurTrace = "\n\nHeuristics Info:\n"
+# The recursion bound which lets Corral inline completely.
+FULL_RECURSION_BOUND = 65536
 
-  from smack.top import VProperty
-  from smack.top import VResult
+# The wall-clock time limit of SV-COMP, in seconds, and the part of it which
+# is reserved for writing the witness.
+SVCOMP_TIME_LIMIT = 900
+WITNESS_RESERVE = 20
 
-  if not (VProperty.MEMORY_SAFETY in args.check
-          or VProperty.MEMLEAK in args.check
-          or VProperty.INTEGER_OVERFLOW in args.check):
-    inject_assert_false(args)
+# The least time worth starting a strategy with, in seconds.
+MIN_BUDGET = 10
 
-  # Setting good loop unroll bound based on benchmark class
-  loopUnrollBar = 13
-  time_limit = 880
+# The number of memory regions beyond which the bit-vector encoding is too
+# expensive to confirm errors with.
+REGION_BAR = 64
+
+START_TIME = time.time()
+
+class Strategy:
+  """A verification attempt: the verifier, the encoding of the program, the
+  recursion bound of Corral, and the share of the remaining time it gets,
+  unless it is the last attempt, which gets all of it. Errors are reported
+  right away only by strategies whose encoding is precise for the program."""
+
+  def __init__(self, name, verifier='corral', bound=FULL_RECURSION_BOUND,
+               share=1.0, precise=True, encoding=None, floats=False):
+    self.name = name
+    self.verifier = verifier
+    self.bound = bound
+    self.share = share
+    self.precise = precise
+    self.encoding = encoding
+    self.floats = floats
+
+def program_features(bpl_file):
+  """Cheap features of the Boogie program: its number of loops, i.e., of back
+  edges, and of memory regions, and whether it uses floating-point
+  operations, threads, and bitwise operations which were not rewritten."""
+
+  features = {'loops': 0, 'regions': 0, 'floats': False, 'pthreads': False,
+              'bitwise': False}
+  labels = set()
+  with open(bpl_file, 'r') as f:
+    for line in f:
+      line = line.strip()
+      if line.startswith('procedure '):
+        labels = set()
+      elif re.match(r'({[^}]*}\s*)*var \$M\.\d+:', line):
+        features['regions'] += 1
+      elif re.match(r'[\w$.#]+:$', line):
+        labels.add(line[:-1])
+      elif line.startswith('goto '):
+        targets = line[len('goto '):].rstrip(';').split(',')
+        features['loops'] += len([t for t in targets if t.strip() in labels])
+      elif re.match(r'call\b.*\bpthread_create\(', line):
+        features['pthreads'] = True
+      elif re.search(r':= \$(fadd|fsub|fmul|fdiv|frem|fneg|si2fp|ui2fp|'
+                     r'fp2si|fp2ui)\.', line):
+        features['floats'] = True
+      elif re.search(r':= \$(and|or|xor|nand|shl|lshr|ashr)\.', line):
+        features['bitwise'] = True
+  return features
+
+def select_strategies(features, loopUnrollBar):
+  """The sequence of strategies for a program with the given features."""
+
+  imprecise = features['floats'] or features['bitwise']
+  inline = Strategy('inline', share=0.6, precise=not imprecise)
+  bounded = Strategy('bounded', bound=loopUnrollBar, share=0.4,
+                     precise=not imprecise)
+  if features['loops'] == 0:
+    # Without loops, inlining completes unless the program recurses, and so
+    # does Boogie, which cannot verify threads.
+    strategies = [inline]
+    if not features['pthreads']:
+      inline.share = 0.7
+      strategies.append(Strategy('boogie', verifier='boogie',
+                                 bound=loopUnrollBar, precise=not imprecise))
+  elif features['pthreads']:
+    # Bugs in threads tend to be shallow.
+    strategies = [bounded, inline]
+  else:
+    strategies = [inline, bounded]
+  if imprecise and features['regions'] <= REGION_BAR:
+    strategies.append(Strategy('bit-vector', encoding='bit-vector',
+                               floats=features['floats']))
+  return strategies
+
+def translate_strategy(strategy, args):
+  """The copy of the arguments for the strategy, with the program translated
+  anew when its verifier or its encoding differs."""
+
+  config = copy.copy(args)
+  config.portfolio = None
+  config.configurations = []
+  config.unroll = strategy.bound
+  if strategy.verifier == 'corral' and not strategy.encoding:
+    return config
+
+  if strategy.verifier != 'corral':
+    config.verifier = strategy.verifier
+  if strategy.encoding:
+    config.integer_encoding = strategy.encoding
+    config.float = config.float or strategy.floats
+  config.ll_file = None
+  config.bpl_file = smack.top.derived_file(args.bpl_file, strategy.name, args)
+  smack.top.llvm_to_bpl(config)
+  if needs_assert_false(config):
+    inject_assert_false(config)
+  return config
+
+def run_strategy(strategy, config, time_limit):
+  """Run the verifier of the strategy, and return its result and output."""
+
+  if strategy.verifier != 'corral':
+    config.time_limit = time_limit
+    return smack.top.run_verifier(config)
 
   corral_command = ["corral"]
-  corral_command += [args.bpl_file]
+  corral_command += [config.bpl_file]
   corral_command += ["/tryCTrace", "/noTraceOnDisk", "/printDataValues:1"]
   corral_command += ["/useProverEvaluate", "/cex:1"]
   corral_command += ["/bopt:proverOpt:O:smt.qi.eager_threshold=100"]
   corral_command += ["/bopt:proverOpt:O:smt.arith.solver=2"]
   corral_command += ["/timeLimit:%s" % time_limit]
   corral_command += ["/v:1"]
-  corral_command += ["/recursionBound:65536"]
+  corral_command += ["/recursionBound:%d" % strategy.bound]
   corral_command += ["/trackAllVars"]
 
-  verifier_output = smack.top.try_command(corral_command, timeout=time_limit)
+  try:
+    verifier_output = smack.top.try_command(corral_command, timeout=time_limit)
+  except smack.top.MemoryLimitExceeded as err:
+    return smack.top.VResult.MEMOUT, str(err)
   result = smack.top.verification_result(verifier_output, 'corral')
+  return result, verifier_output
 
-  if result in VResult.ERROR: #normal inlining
-    heurTrace += "Found a bug during normal inlining.\n"
+def exhausted_recursion_bound(verifier_output):
+  """How far Corral unrolled, ignoring the recursion bounds exhausted while it
+  computed the static loop bounds, or None when it did not start
+  verification."""
 
-    if not args.quiet:
-      error = smack.top.error_trace(verifier_output, 'corral')
-      print(error)
+  if 'Verifying program while tracking' not in verifier_output:
+    return None
+  verifier_output = re.sub(re.compile('.*Verifying program while tracking', re.DOTALL),
+    'Verifying program while tracking', verifier_output)
+  unrollMax = 0
+  it = re.finditer(r'Exhausted recursion bound of ([1-9]\d*)', verifier_output)
+  for match in it:
+    unrollMax = max(unrollMax, int(match.group(1)))
+  return unrollMax
 
-  elif result is VResult.TIMEOUT: #normal inlining
-    heurTrace += "Timed out during normal inlining.\n"
-    heurTrace += "Determining result based on how far we unrolled.\n"
-    # If we managed to unroll more than loopUnrollBar times, then return verified
-    # First remove exhausted loop bounds generated during max static loop bound computation
-    unrollMax = 0
-    if 'Verifying program while tracking' in verifier_output:
-      verifier_output = re.sub(re.compile('.*Verifying program while tracking', re.DOTALL),
-        'Verifying program while tracking', verifier_output)
-      it = re.finditer(r'Exhausted recursion bound of ([1-9]\d*)', verifier_output)
-      for match in it:
-        if int(match.group(1)) > unrollMax:
-          unrollMax = int(match.group(1))
-    else:
-      heurTrace += "Corral didn't even start verification.\n"
-    if unrollMax >= loopUnrollBar:
-      heurTrace += "Unrolling made it to a recursion bound of "
-      heurTrace += str(unrollMax) + ".\n"
-      heurTrace += "Reporting benchmark as 'verified'.\n"
-      if not args.quiet:
-        print((heurTrace + "\n"))
-      write_error_file(args, VResult.VERIFIED, verifier_output)
-      print(VResult.VERIFIED.message(args))
-      sys.exit(VResult.VERIFIED.return_code())
+def verify_bpl_svcomp(args):
+  """Verify the Boogie source file using SVCOMP-tuned heuristics.
+
+  The wall-clock time left is scheduled across a sequence of strategies, which
+  is chosen by cheap features of the program. Each strategy gets its share of
+  the time left when it starts, so that a hung attempt leaves time for the
+  others. The first definitive result stands, except that errors found under
+  an imprecise encoding of floating-point or bitwise operations are confirmed
+  under the bit-vector encoding when time allows. Otherwise, the result is
+  determined by how far Corral unrolled."""
+  heurTrace = "\n\nHeuristics Info:\n"
+
+  from smack.top import VResult
+
+  if needs_assert_false(args):
+    inject_assert_false(args)
+
+  # Setting good loop unroll bound based on benchmark class
+  loopUnrollBar = 13
+  deadline = (START_TIME + min(args.time_limit, SVCOMP_TIME_LIMIT)
+              - WITNESS_RESERVE)
+
+  features = program_features(args.bpl_file)
+  heurTrace += "Program features: %d loops, %d memory regions" % (
+    features['loops'], features['regions'])
+  for feature in ['floats', 'pthreads', 'bitwise']:
+    if features[feature]:
+      heurTrace += ", " + feature
+  heurTrace += ".\n"
+  strategies = select_strategies(features, loopUnrollBar)
+  heurTrace += "Strategies: %s.\n" % ", ".join(s.name for s in strategies)
+  if ((features['floats'] or features['bitwise'])
+      and features['regions'] > REGION_BAR):
+    heurTrace += "Too many memory regions to confirm bugs with bit-vectors.\n"
+
+  decided = None
+  suspect = None
+  failed = None
+  unrollMax = 0
+  unrollOutput = ''
+  started = False
+  for i, strategy in enumerate(strategies):
+    if suspect and not strategy.precise:
+      continue
+    start = time.time()
+    remaining = deadline - start
+    budget = remaining
+    if i < len(strategies) - 1:
+      budget *= strategy.share
+    if budget < MIN_BUDGET:
+      heurTrace += "Skipped %s with %d seconds left.\n" % (strategy.name,
+                                                           remaining)
+      continue
+    try:
+      config = translate_strategy(strategy, args)
+    except Exception:
+      heurTrace += "Could not translate the program for %s.\n" % strategy.name
+      continue
+    time_limit = int(budget - (time.time() - start))
+    if time_limit < MIN_BUDGET:
+      heurTrace += "Skipped %s after its translation.\n" % strategy.name
+      continue
+    heurTrace += "Running %s for %d seconds.\n" % (strategy.name, time_limit)
+    result, verifier_output = run_strategy(strategy, config, time_limit)
+    outcome = (strategy.verifier, result, verifier_output)
+    if result in VResult.ERROR:
+      if strategy.precise:
+        heurTrace += "Found a bug with %s.\n" % strategy.name
+        decided = outcome
+        break
+      heurTrace += "Found a bug with %s, which may be spurious.\n" % (
+        strategy.name)
+      suspect = outcome
+    elif result is VResult.VERIFIED:
+      if strategy.bound < FULL_RECURSION_BOUND:
+        heurTrace += "%s found no bugs up to a recursion bound of %d.\n" % (
+          strategy.name, strategy.bound)
+      else:
+        heurTrace += "%s terminated and found no bugs.\n" % strategy.name
+      decided = outcome
+      break
+    elif result is VResult.TIMEOUT and strategy.verifier == 'corral':
+      heurTrace += "Timed out with %s.\n" % strategy.name
+      bound = exhausted_recursion_bound(verifier_output)
+      if bound is not None:
+        started = True
+        if bound >= unrollMax:
+          unrollMax = bound
+          unrollOutput = verifier_output
     else:
-      heurTrace += "Only unrolled " + str(unrollMax) + " times.\n"
-      heurTrace += "Insufficient unrolls to consider 'verified'.  "
-      heurTrace += "Reporting 'timeout'.\n"
-      if not args.quiet:
-        print((heurTrace + "\n"))
-        sys.stdout.flush()
-      force_timeout()
-  elif result is VResult.VERIFIED: #normal inlining
-    heurTrace += "Normal inlining terminated and found no bugs.\n"
-  else: #normal inlining
-    heurTrace += "Normal inlining returned 'unknown'.  See errors above.\n"
-  if not args.quiet:
-    print((heurTrace + "\n"))
-  write_error_file(args, result, verifier_output)
-  print(result.message(args))
-  sys.exit(result.return_code())
-
-def write_error_file(args, status, verifier_output):
+      heurTrace += "%s returned '%s'.\n" % (strategy.name, result)
+      if result is not VResult.TIMEOUT:
+        failed = outcome
+
+  if not decided and suspect:
+    heurTrace += "Could not confirm the bug; reporting it anyway.\n"
+    decided = suspect
+  elif not decided and failed and not started:
+    heurTrace += "No strategy succeeded.  See errors above.\n"
+    decided = failed
+
+  if decided:
+    verifier, result, verifier_output = decided
+    if result in VResult.ERROR and not args.quiet:
+      error = smack.top.error_trace(verifier_output, verifier)
+      print(error)
+    if not args.quiet:
+      print((heurTrace + "\n"))
+    write_error_file(args, result, verifier_output, verifier)
+    print(result.message(args))
+    sys.exit(result.return_code())
+
+  heurTrace += "Determining result based on how far we unrolled.\n"
+  if not started:
+    heurTrace += "Corral didn't even start verification.\n"
+  if unrollMax >= loopUnrollBar:
+    heurTrace += "Unrolling made it to a recursion bound of "
+    heurTrace += str(unrollMax) + ".\n"
+    heurTrace += "Reporting benchmark as 'verified'.\n"
+    if not args.quiet:
+      print((heurTrace + "\n"))
+    write_error_file(args, VResult.VERIFIED, unrollOutput)
+    print(VResult.VERIFIED.message(args))
+    sys.exit(VResult.VERIFIED.return_code())
+  else:
+    heurTrace += "Only unrolled " + str(unrollMax) + " times.\n"
+    heurTrace += "Insufficient unrolls to consider 'verified'.  "
+    heurTrace += "Reporting 'timeout'.\n"
+    if not args.quiet:
+      print((heurTrace + "\n"))
+      sys.stdout.flush()
+    force_timeout()
+
+def write_error_file(args, status, verifier_output, verifier='corral'):
   from smack.top import VProperty
   from smack.top import VResult
   from smack.errtrace import json_output_str
@@ -168,9 +379,9 @@ def write_error_file(args, status, verifier_output):
   if args.error_file:
     error = None
     if args.language == 'svcomp':
-      error = smackJsonToXmlGraph(json_output_str(status, verifier_output, 'corral', False), args, hasBug, status)
+      error = smackJsonToXmlGraph(json_output_str(status, verifier_output, verifier, False), args, hasBug, status)
     elif hasBug:
-      error = smack.top.error_trace(verifier_output, 'corral')
+      error = smack.top.error_trace(verifier_output, verifier)
     if error is not None:
       with open(args.error_file, 'w') as f:
         f.write(error.decode('utf-8'))
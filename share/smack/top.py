@@ -1,16 +1,22 @@
 import argparse
+import copy
 import os
 import re
 import sys
 import shlex
+import shutil
 import subprocess
 import signal
 import functools
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
 from enum import Flag, auto
 from .svcomp.utils import verify_bpl_svcomp
 from .utils import temporary_file, try_command, remove_temp_files,\
-    llvm_exact_bin
+    llvm_exact_bin, derived_file, run_parallel, ProcessGroup, try_server, \
+    MemoryLimitExceeded, resource_usage
 from .replay import replay_error_trace
+from .cache import ResultCache, default_cache_dir
 from .frontend import link_bc_files, frontends, languages, extra_libs
 from .errtrace import error_trace, json_output_str
 
@@ -32,6 +38,7 @@ class VResult(Flag):
     OVERFLOW = auto()
     RUST_PANIC = auto()
     TIMEOUT = auto()
+    MEMOUT = auto()
     UNKNOWN = auto()
     MEMSAFETY_ERROR = INVALID_DEREF | INVALID_FREE | INVALID_MEMTRACK
     ERROR = (ASSERTION_FAILURE | INVALID_DEREF | INVALID_FREE
@@ -68,6 +75,7 @@ class VResult(Flag):
             VResult.INVALID_MEMTRACK: 4,
             VResult.OVERFLOW: 5,
             VResult.RUST_PANIC: 6,
+            VResult.MEMOUT: 125,
             VResult.TIMEOUT: 126,
             VResult.UNKNOWN: 127}
 
@@ -90,6 +98,8 @@ class VResult(Flag):
                     + (': %s' % description if description else '') + '.')
         elif self is VResult.TIMEOUT:
             return 'SMACK timed out.'
+        elif self is VResult.MEMOUT:
+            return 'SMACK ran out of memory.'
         elif self is VResult.UNKNOWN:
             return 'SMACK result is unknown.'
         else:
@@ -228,6 +238,50 @@ class FileAction(argparse.Action):
         setattr(namespace, self.dest, values)
 
 
+VERIFIERS = ['boogie', 'corral', 'symbooglix']
+SOLVERS = ['z3', 'cvc4', 'yices2']
+SOLVER_BINARIES = {'z3': 'z3', 'cvc4': 'cvc4', 'yices2': 'yices-smt2'}
+DEFAULT_PORTFOLIO = ['corral:z3', 'corral:cvc4', 'boogie:z3']
+
+
+def portfolio_configuration(s):
+    '''Parse a portfolio configuration VERIFIER[:SOLVER[:OPTIONS]].'''
+    verifier, _, rest = s.partition(':')
+    solver, _, options = rest.partition(':')
+    solver = solver or 'z3'
+    if verifier not in VERIFIERS:
+        raise argparse.ArgumentTypeError('invalid verifier: %s' % verifier)
+    if solver not in SOLVERS:
+        raise argparse.ArgumentTypeError('invalid solver: %s' % solver)
+    return (verifier, solver, options)
+
+
+def unroll_bound(s):
+    '''Parse an unroll bound: a positive integer, or auto.'''
+    if s == 'auto':
+        return s
+    try:
+        n = int(s)
+    except ValueError:
+        n = 0
+    if n < 1:
+        raise argparse.ArgumentTypeError('Unroll bound has to be positive.')
+    return n
+
+
+def property_split(s):
+    '''Parse a property split: by kind, or round-robin into N variants.'''
+    if s == 'kind':
+        return s
+    try:
+        n = int(s)
+    except ValueError:
+        n = 0
+    if n < 2:
+        raise argparse.ArgumentTypeError('invalid property split: %s' % s)
+    return n
+
+
 def exit_with_error(error):
     sys.exit('Error: %s.' % error)
 
@@ -333,6 +387,54 @@ def arguments():
     parser.add_argument('--json-file', metavar='FILE', default=None,
                         type=str, help='generate JSON output to FILE')
 
+    parser.add_argument(
+        '-j',
+        '--jobs',
+        metavar='N',
+        default=os.cpu_count() or 1,
+        type=int,
+        help='''maximum number of translator and verifier processes to run in
+                parallel [default: number of CPUs]''')
+
+    parser.add_argument(
+        '--llvm2bpl-server',
+        metavar='SOCKET',
+        default=os.environ.get('SMACK_LLVM2BPL_SERVER'),
+        type=str,
+        help='''translate with the server started by llvm2bpl --serve SOCKET
+                when it is listening [default: $SMACK_LLVM2BPL_SERVER]''')
+
+    parser.add_argument(
+        '--no-cache',
+        action='store_true',
+        default=False,
+        help='''do not look up or store verification results and library
+                bitcode in the cache''')
+
+    parser.add_argument(
+        '--cache-dir',
+        metavar='DIR',
+        default=default_cache_dir(),
+        type=str,
+        help='''cache verification results and library bitcode in DIR
+                [default: %(default)s]''')
+
+    parser.add_argument(
+        '--cache-size',
+        metavar='MB',
+        default=256,
+        type=int,
+        help='''maximum size of the cached verification results
+                [default: %(default)s]''')
+
+    parser.add_argument(
+        '--memory-limit',
+        metavar='MB',
+        default=None,
+        type=int,
+        help='''limit the address space of each process spawned, e.g., the
+                compiler and the verifier, to MB megabytes''')
+
     frontend_group = parser.add_argument_group('front-end options')
 
     frontend_group.add_argument('-x', '--language', metavar='LANG',
@@ -402,6 +504,14 @@ def arguments():
         help='''attempts to provide models for bitwise operations
                 when integer encoding is used''')
 
+    translate_group.add_argument(
+        '--bit-precise-bitwise-ops',
+        action="store_true",
+        default=False,
+        help='''model bitwise operations with SMT bit-vector theory when
+                integer encoding is used, converting their operands and
+                results; other operations keep the integer encoding''')
+
     translate_group.add_argument(
         '--no-memory-splitting',
         action="store_true",
@@ -437,6 +547,21 @@ def arguments():
         type=int,
         help='bound on the number of threads [default: %(default)s]')
 
+    translate_group.add_argument(
+        '--lazy-sequentialization',
+        action='store_true',
+        default=False,
+        help='''translate pthread programs into sequential programs which
+                interleave threads in bounded rounds (implies --pthread)''')
+
+    translate_group.add_argument(
+        '--rounds',
+        metavar='N',
+        default='2',
+        type=int,
+        help='''bound on the number of scheduling rounds of lazy
+                sequentialization [default: %(default)s]''')
+
     translate_group.add_argument(
         '--integer-encoding',
         choices=['bit-vector', 'unbounded-integer', 'wrapped-integer'],
@@ -475,6 +600,13 @@ def arguments():
         default=['main'],
         help='specify top-level procedures [default: %(default)s]')
 
+    translate_group.add_argument(
+        '--split-entry-points',
+        action='store_true',
+        default=False,
+        help='''translate and verify each entry point separately, restricted to
+                the code reachable from it''')
+
     translate_group.add_argument(
         '--checked-functions',
         metavar='PROC',
@@ -529,6 +661,43 @@ def arguments():
         help='''Add assert false to the end of each loop
                 (useful for deciding how much unroll to use)''')
 
+    translate_group.add_argument(
+        '--scalarize-vectors',
+        action='store_true',
+        default=False,
+        help='''lower SIMD vector operations, loads and stores into
+                per-lane scalar operations''')
+
+    translate_group.add_argument(
+        '--merge-functions',
+        action='store_true',
+        default=False,
+        help='''fold functions with identical translations, e.g., Rust and C++
+                generic instantiations, into a single procedure''')
+
+    translate_group.add_argument(
+        '--inline-leaf-functions',
+        action='store_true',
+        default=False,
+        help='''inline small non-recursive leaf functions, e.g., SMACK runtime
+                helpers, before the translation''')
+
+    translate_group.add_argument(
+        '--inline-threshold',
+        metavar='N',
+        default=16,
+        type=int,
+        help='''bound on the estimated verification-condition size of the
+                functions inlined by --inline-leaf-functions
+                [default: %(default)s]''')
+
+    translate_group.add_argument(
+        '--infer-loop-invariants',
+        action='store_true',
+        default=False,
+        help='''infer interval loop invariants, and check and assume them at
+                loop headers (unbounded integer encoding only)''')
+
     verifier_group = parser.add_argument_group('verifier options')
 
     verifier_group.add_argument(
@@ -549,9 +718,19 @@ def arguments():
         '--unroll',
         metavar='N',
         default='1',
+        type=unroll_bound,
+        help='''loop/recursion unroll bound, or auto to start from 1 and double
+                the bound until an error is found, the bound exceeds
+                --max-unroll, or the time limit runs out
+                [default: %(default)s]''')
+
+    verifier_group.add_argument(
+        '--max-unroll',
+        metavar='N',
+        default='64',
         type=lambda x: (int(x) if int(x) > 0 else
                         parser.error('Unroll bound has to be positive.')),
-        help='loop/recursion unroll bound [default: %(default)s]')
+        help='maximum unroll bound of --unroll auto [default: %(default)s]')
 
     verifier_group.add_argument(
         '--loop-limit',
@@ -589,6 +768,31 @@ def arguments():
         type=int,
         help='maximum reported assertion violations [default: %(default)s]')
 
+    verifier_group.add_argument(
+        '--portfolio',
+        metavar='CONFIG',
+        nargs='*',
+        default=None,
+        type=portfolio_configuration,
+        help=('''run several verifier configurations concurrently, each of the
+                 form VERIFIER[:SOLVER[:OPTIONS]], and report the first
+                 definitive result [default: %s, less the solvers which
+                 are not installed]''' %
+              ' '.join(DEFAULT_PORTFOLIO)))
+
+    verifier_group.add_argument(
+        '--split-properties',
+        metavar='SPLIT',
+        nargs='?',
+        const='kind',
+        default=None,
+        type=property_split,
+        help='''verify the assertions in separate variants of the program,
+                concurrently, where each variant checks some assertions and
+                assumes the others; the assertions are grouped by the kind of
+                property they check when SPLIT is kind, or dealt round-robin
+                into SPLIT variants [default: kind]''')
+
     verifier_group.add_argument(
         '--svcomp-property',
         metavar='FILE',
@@ -627,6 +831,10 @@ def arguments():
 
     args = parser.parse_args()
 
+    # Bitcode is linked in memory by llvm2bpl unless it must be saved.
+    args.save_bc = args.bc_file is not None or args.replay
+    args.save_linked_bc = args.linked_bc_file is not None
+
     if not args.bc_file:
         args.bc_file = temporary_file('a', '.bc', args)
 
@@ -640,6 +848,22 @@ def arguments():
     if args.check == VProperty.NONE:
         args.check = VProperty.ASSERTIONS
 
+    if args.lazy_sequentialization:
+        args.pthread = True
+
+    args.cache = None if args.no_cache else ResultCache(
+        args.cache_dir, args.cache_size << 20)
+
+    args.auto_unroll = args.unroll == 'auto'
+    if args.auto_unroll:
+        args.unroll = 1
+
+    # The default portfolio omits the solvers which are not installed.
+    if args.portfolio == []:
+        args.portfolio = [c for c in map(portfolio_configuration,
+                                         DEFAULT_PORTFOLIO)
+                          if shutil.which(SOLVER_BINARIES[c[1]])]
+
     # TODO are we (still) using this?
     # with open(args.input_file, 'r') as f:
     #   for line in f.readlines():
@@ -674,7 +898,6 @@ def target_selection(args):
 
 def frontend(args):
     """Generate the LLVM bitcode file."""
-    bitcodes = []
     libs = set()
     noreturning_frontend = False
 
@@ -682,37 +905,165 @@ def frontend(args):
         if lang in extra_libs():
             libs.add(extra_libs()[lang])
 
-    if args.language:
-        lang = languages()[args.language]
+    units = []
+    for input_file in args.input_files:
+        if args.language:
+            lang = languages()[args.language]
+        else:
+            lang = languages()[os.path.splitext(input_file)[1][1:]]
         if lang in ['boogie', 'svcomp', 'json']:
             noreturning_frontend = True
 
         add_libs(lang)
-        frontend = frontends()[lang]
-        for input_file in args.input_files:
-            bitcode = frontend(input_file, args)
-            if bitcode is not None:
-                bitcodes.append(bitcode)
+        units.append((frontends()[lang], input_file))
 
-    else:
-        for input_file in args.input_files:
-            lang = languages()[os.path.splitext(input_file)[1][1:]]
-            if lang in ['boogie', 'svcomp', 'json']:
-                noreturning_frontend = True
+    # Frontends which do not return run the rest of the pipeline themselves,
+    # and must run in order; the others compile independent units.
+    if noreturning_frontend:
+        for frontend, input_file in units:
+            frontend(input_file, args)
+        return
+
+    bitcodes = run_parallel(lambda u: u[0](u[1], args), units, args.jobs)
+    bitcodes = [bc for bc in bitcodes if bc is not None]
+    return link_bc_files(bitcodes, libs, args)
+
+
+def entry_point_partitions(args):
+    """Partition the program by entry point, unless it is verified as a whole.
+
+    Each partition is translated with its entry point only, for which llvm2bpl
+    internalizes and prunes the code unreachable from it, and analyzes the
+    memory regions of the remaining code in isolation.
+    """
+
+    if not hasattr(args, 'partitions'):
+        partitions = []
+        if (args.split_entry_points and len(args.entry_points) > 1
+                and args.verifier != 'svcomp'):
+            for ep in args.entry_points:
+                part = copy.copy(args)
+                part.entry_points = [ep]
+                part.partitions = []
+                part.jobs = max(args.jobs // len(args.entry_points), 1)
+                part.bpl_file = derived_file(args.bpl_file, ep, args)
+                partitions.append(part)
+        args.partitions = partitions
+    return args.partitions
+
+
+def portfolio_configurations(args):
+    """The copies of the arguments for each configuration of the portfolio.
+
+    Configurations with the same verifier share a Boogie source file, since the
+    annotations of the translation depend on the verifier.
+    """
+
+    if not hasattr(args, 'configurations'):
+        configurations = []
+        for verifier, solver, options in args.portfolio or []:
+            config = copy.copy(args)
+            config.portfolio = None
+            config.verifier = verifier
+            config.solver = solver
+            config.verifier_options = " ".join(
+                o for o in [args.verifier_options, options] if o)
+            if verifier != args.verifier:
+                config.bpl_file = derived_file(args.bpl_file, verifier, args)
+            configurations.append(config)
+        args.configurations = configurations
+    return args.configurations
+
+
+ASSERTION = re.compile(r'^(\s*)assert\b(\s*{:(\w+))?')
+
+
+def assertion_groups(bpl, split):
+    '''Group the assertions of the Boogie source BPL, indexed by line, by
+    property kind or round-robin. Loop invariants are never assumed, and
+    assertions without a property attribute are user assertions.'''
+
+    kinds = [p.boogie_attr() for p in VProperty.mem_safe_subprops()
+             + [VProperty.INTEGER_OVERFLOW, VProperty.RUST_PANICS]]
+    groups = {}
+    count = 0
+    for i, line in enumerate(bpl):
+        m = ASSERTION.match(line)
+        if not m or m.group(3) == 'loopinvariant':
+            continue
+        if split == 'kind':
+            key = m.group(3) if m.group(3) in kinds else 'assertions'
+        else:
+            key = 'part%d' % (count % split)
+        groups.setdefault(key, set()).add(i)
+        count += 1
+    return groups
+
+
+def restrict_assertions(src, dst, split, key):
+    '''Copy the Boogie source file SRC to DST, where the assertions outside
+    the group KEY become assumptions.'''
+
+    with open(src, 'r') as f:
+        bpl = f.readlines()
+    lines = assertion_groups(bpl, split).get(key, set())
+    with open(dst, 'w') as f:
+        for i, line in enumerate(bpl):
+            m = ASSERTION.match(line)
+            if m and i not in lines and m.group(3) != 'loopinvariant':
+                line = m.group(1) + 'assume' + line[m.end(1) + 6:]
+            f.write(line)
+
+
+def property_variants(args):
+    """The copies of the arguments for each variant of the program, which
+    checks one group of assertions and assumes the others.
 
-            add_libs(lang)
-            bitcode = frontends()[lang](input_file, args)
-            if bitcode is not None:
-                bitcodes.append(bitcode)
+    A violation found in a variant is a violation of the program, since the
+    assumed assertions hold along the violating execution. Each configuration
+    of the portfolio gets its own copy of each variant.
+    """
 
-    if not noreturning_frontend:
-        return link_bc_files(bitcodes, libs, args)
+    if not args.split_properties:
+        return []
+
+    with open(args.bpl_file, 'r') as f:
+        groups = assertion_groups(f.readlines(), args.split_properties)
+
+    variants = []
+    if len(groups) < 2:
+        return variants
+    for key in sorted(groups):
+        files = {}
+
+        def restricted(a):
+            if a.bpl_file not in files:
+                files[a.bpl_file] = derived_file(a.bpl_file, key, args)
+                restrict_assertions(a.bpl_file, files[a.bpl_file],
+                                    args.split_properties, key)
+            a = copy.copy(a)
+            a.bpl_file = files[a.bpl_file]
+            return a
+
+        variant = restricted(args)
+        variant.split_properties = None
+        variant.property_group = key
+        variant.configurations = [restricted(c)
+                                  for c in portfolio_configurations(args)]
+        variants.append(variant)
+    return variants
 
 
 def llvm_to_bpl(args):
     """Translate the LLVM bitcode file to a Boogie source file."""
 
-    cmd = ['llvm2bpl', args.linked_bc_file, '-bpl', args.bpl_file]
+    partitions = entry_point_partitions(args)
+    if partitions:
+        run_parallel(llvm_to_bpl, partitions, args.jobs)
+        return
+
+    cmd = ['llvm2bpl'] + getattr(args, 'translated_bc_files',
+                                 [args.linked_bc_file])
     cmd += ['-warn-type', args.warn]
     cmd += ['-sea-dsa=ci']
     # This flag can lead to unsoundness in Rust regressions.
@@ -728,14 +1079,14 @@ def llvm_to_bpl(args):
         cmd += ['-debug']
     if args.debug_only:
         cmd += ['-debug-only', args.debug_only]
-    if args.ll_file:
-        cmd += ['-ll', args.ll_file]
     if "impls" in args.mem_mod:
         cmd += ['-mem-mod-impls']
     if args.static_unroll:
         cmd += ['-static-unroll']
     if args.integer_encoding == 'bit-vector':
         cmd += ['-bit-precise']
+        if args.solver == 'z3' and args.verifier != 'symbooglix':
+            cmd += ['-bv-overflow-builtins']
     if args.integer_encoding == 'wrapped-integer':
         cmd += ['-wrapped-integer-encoding']
     if args.timing_annotations:
@@ -746,6 +1097,8 @@ def llvm_to_bpl(args):
         cmd += ['-no-byte-access-inference']
     if args.rewrite_bitwise_ops:
         cmd += ['-rewrite-bitwise-ops']
+    if args.bit_precise_bitwise_ops:
+        cmd += ['-bit-precise-bitwise-ops']
     if args.no_memory_splitting:
         cmd += ['-no-memory-splitting']
     if args.check.contains_mem_safe_props():
@@ -756,77 +1109,63 @@ def llvm_to_bpl(args):
         cmd += ['-rust-panics']
     if args.fail_on_loop_exit:
         cmd += ['-fail-on-loop-exit']
+    if args.infer_loop_invariants:
+        cmd += ['-infer-loop-invariants']
+    if args.scalarize_vectors:
+        cmd += ['-scalarize-vectors', '-scalarize-load-store']
+    if args.merge_functions:
+        cmd += ['-merge-functions']
+    if args.inline_leaf_functions:
+        cmd += ['-inline-leaf-functions']
+        cmd += ['-inline-leaf-threshold=' + str(args.inline_threshold)]
+    if args.lazy_sequentialization:
+        cmd += ['-lazy-sequentialization']
+        cmd += ['-sequentialization-rounds=' + str(args.rounds)]
     if args.llvm_assumes:
         cmd += ['-llvm-assumes=' + args.llvm_assumes]
     if args.float:
         cmd += ['-float']
     if args.modular:
         cmd += ['-modular']
-    try_command(cmd, console=True)
-    annotate_bpl(args)
-    memsafety_subproperty_selection(args)
-    transform_bpl(args)
-
-
-def procedure_annotation(name, args):
-    if name in args.entry_points:
-        return "{:entrypoint}"
-    elif (args.modular and
-          re.match("|".join(inlined_procedures()).replace("$", r"\$"), name)):
-        return "{:inline 1}"
-    elif (not args.modular) and args.verifier == 'boogie':
-        return ("{:inline %s}" % args.unroll)
-    else:
-        return ""
-
 
-def annotate_bpl(args):
-    """Annotate the Boogie source file with additional metadata."""
-
-    proc_decl = re.compile(r'procedure\s+([^\s(]*)\s*\(')
-
-    with open(args.bpl_file, 'r+') as f:
-        bpl = "// generated by SMACK version %s for %s\n" % (
-            VERSION, args.verifier)
-        bpl += "// via %s\n\n" % " ".join(sys.argv)
-        bpl += proc_decl.sub(
-            lambda m: ("procedure %s %s(" %
-                       (procedure_annotation(m.group(1), args), m.group(1))),
-            f.read())
-        f.seek(0)
-        f.truncate()
-        f.write(bpl)
-
-
-def memsafety_subproperty_selection(args):
-    if VProperty.MEMORY_SAFETY in args.check:
-        return
-
-    selected_props = [p.boogie_attr() for p in VProperty.mem_safe_subprops()
-                      if p in args.check]
-
-    def replace_assertion(m):
-        if len(selected_props) > 0:
-            if m.group(2) and m.group(3) in selected_props:
-                attrib = m.group(2)
-                expr = m.group(4)
-            else:
-                attrib = ''
-                expr = 'true'
-            return m.group(1) + attrib + expr + ";"
-        else:
-            return m.group(0)
-
-    with open(args.bpl_file, 'r+') as f:
-        lines = f.readlines()
-        f.seek(0)
-        f.truncate()
-        for line in lines:
-            line = re.sub(
-                r'^(\s*assert\s*)({:(.+)})?(.+);',
-                replace_assertion,
-                line)
-            f.write(line)
+    # Configurations of the portfolio which use other verifiers are translated
+    # concurrently, since llvm2bpl annotates the program for the verifier.
+    targets = [args]
+    for config in portfolio_configurations(args):
+        if all(config.bpl_file != a.bpl_file for a in targets):
+            targets.append(config)
+
+    def translate(a):
+        extra = ['-ll', args.ll_file] if args.ll_file and a is args else []
+        command = (cmd + ['-bpl', a.bpl_file] + extra
+                   + annotation_options(a))
+        if (not args.llvm2bpl_server
+                or try_server(args.llvm2bpl_server, command,
+                              console=True) is None):
+            try_command(command, console=True)
+        transform_bpl(a)
+
+    run_parallel(translate, targets, args.jobs)
+
+
+def annotation_options(args):
+    """The options of llvm2bpl which annotate the Boogie source file with
+    additional metadata, and select the assertions of the memory-safety
+    subproperties checked."""
+
+    opts = ['-bpl-header', 'generated by SMACK version %s for %s' %
+            (VERSION, args.verifier)]
+    opts += ['-bpl-header', 'via %s' % ' '.join(sys.argv)]
+    if args.modular:
+        for prefix in inlined_procedures():
+            opts += ['-inline-procedures', prefix]
+    elif args.verifier == 'boogie':
+        opts += ['-inline-bound', str(args.unroll)]
+    if VProperty.MEMORY_SAFETY not in args.check:
+        for p in VProperty.mem_safe_subprops():
+            if p in args.check:
+                opts += ['-selected-assertions', p.boogie_attr()]
+    return opts
 
 
 def transform_bpl(args):
@@ -901,14 +1240,10 @@ def verification_result(verifier_output, verifier):
         return VResult.UNKNOWN
 
 
-def verify_bpl(args):
-    """Verify the Boogie source file with a back-end verifier."""
-
-    if args.verifier == 'svcomp':
-        verify_bpl_svcomp(args)
-        return
+def run_verifier(args, group=None):
+    """Run the back-end verifier on the Boogie source file."""
 
-    elif args.verifier == 'boogie' or args.modular:
+    if args.verifier == 'boogie' or args.modular:
         command = ["boogie"]
         command += [args.bpl_file]
         command += ["/doModSetAnalysis"]
@@ -953,16 +1288,195 @@ def verify_bpl(args):
     if args.verifier_options:
         command += args.verifier_options.split()
 
-    verifier_output = try_command(command, timeout=args.time_limit)
+    key = None
+    if args.cache:
+        key = args.cache.key(args.bpl_file,
+                             command + ['|', args.transform_out or ''],
+                             [SOLVER_BINARIES[args.solver]])
+        cached = args.cache.lookup(key, args.bpl_file)
+        if cached:
+            return VResult[cached[0]], cached[1]
+
+    try:
+        verifier_output = try_command(command, timeout=args.time_limit,
+                                      group=group)
+    except MemoryLimitExceeded as err:
+        return VResult.MEMOUT, str(err)
     verifier_output = transform_out(args, verifier_output)
     result = verification_result(verifier_output, args.verifier)
+    if key and (result is VResult.VERIFIED or result in VResult.ERROR):
+        args.cache.store(key, args.bpl_file, result.name, verifier_output)
+    return result, verifier_output
+
+
+def unroll_round(args, bound):
+    """The copy of the arguments for a round of iterative deepening.
+
+    The translation is shared by all rounds. Only Boogie needs a copy of it,
+    since it takes the recursion bound from the inline attributes of the
+    procedures. Procedures which are not recursive are inlined completely
+    whatever their bound, so each of these attributes is raised.
+    """
+
+    r = copy.copy(args)
+    r.unroll = bound
+    if r.verifier == 'boogie':
+        r.bpl_file = derived_file(args.bpl_file, 'unroll%d' % bound, args)
+        with open(args.bpl_file, 'r') as f:
+            bpl = f.read()
+        with open(r.bpl_file, 'w') as f:
+            f.write(re.sub(r'^(procedure\s*{:inline )\d+}',
+                           r'\g<1>%d}' % bound, bpl, flags=re.M))
+    return r
+
+
+def run_rounds(args, group=None):
+    """Run the verifier, deepening the unroll bound iteratively with --unroll
+    auto, and return the configuration of the deepest completed round, its
+    result, and the verifier output.
+
+    The bound doubles after each verified round, within the time limit of the
+    whole search. An error ends the search, and so does a timeout or unknown
+    result, in which case the last verified round stands, if any.
+    """
+
+    if not args.auto_unroll or args.modular:
+        return (args,) + run_verifier(args, group)
+
+    deadline = time.time() + args.time_limit
+    completed = None
+    bound = 1
+    while True:
+        r = unroll_round(args, bound)
+        r.time_limit = int(deadline - time.time())
+        if r.time_limit < 1:
+            break
+        result, verifier_output = run_verifier(r, group)
+        if result is not VResult.VERIFIED:
+            if result in VResult.ERROR or not completed:
+                completed = (r, result, verifier_output)
+            break
+        completed = (r, result, verifier_output)
+        if bound >= args.max_unroll or (group and group.killed):
+            break
+        bound = min(bound * 2, args.max_unroll)
+    return completed or (args, VResult.TIMEOUT, '')
+
+
+def run_portfolio(args):
+    """Run the configurations of the portfolio concurrently, at most --jobs
+    at a time.
+
+    The first definitive result, i.e., verified or an error, wins, and the
+    verifiers of the remaining configurations are killed. Otherwise, the
+    outcomes are merged as for entry points.
+    """
+
+    configurations = portfolio_configurations(args)
+    group = ProcessGroup()
+
+    def run(config):
+        if group.killed:
+            return (config, VResult.UNKNOWN, '')
+        try:
+            return run_rounds(config, group)
+        except (Exception, SystemExit) as err:
+            return (config, VResult.UNKNOWN, str(err))
+
+    outcomes = []
+    winner = None
+    workers = max(min(len(configurations), args.jobs), 1)
+    with ThreadPoolExecutor(max_workers=workers) as pool:
+        futures = [pool.submit(run, c) for c in configurations]
+        for future in as_completed(futures):
+            outcome = future.result()
+            if group.killed:
+                continue
+            outcomes.append(outcome)
+            if outcome[1] is VResult.VERIFIED or outcome[1] in VResult.ERROR:
+                group.kill()
+                winner = outcome
+    return winner or merge_outcomes(outcomes)
+
+
+def verify_variant(args):
+    """Verify a Boogie source file, and return the configuration which
+    decided the result, the result, and the verifier output."""
+
+    if args.portfolio:
+        return run_portfolio(args)
+    return run_rounds(args)
+
+
+def verify_partition(args):
+    """Verify a partition of the program, split into its property variants
+    unless it is verified as a whole."""
+
+    variants = property_variants(args)
+    if not variants:
+        return verify_variant(args)
+
+    outcomes = run_parallel(verify_variant, variants, args.jobs)
+    if not args.quiet:
+        prefix = args.entry_points[0] + " " if args.split_entry_points else ""
+        for variant, outcome in zip(variants, outcomes):
+            print("%s%s: %s" % (prefix, variant.property_group, outcome[1]))
+    return merge_outcomes(outcomes)
+
+
+def merge_outcomes(outcomes):
+    """Select the outcome which stands for the whole program: the first error,
+    otherwise the first timeout, memory-out, or unknown result, otherwise a
+    verified one."""
+
+    for results in [VResult.ERROR, VResult.TIMEOUT, VResult.MEMOUT,
+                    VResult.UNKNOWN]:
+        for outcome in outcomes:
+            if outcome[1] in results:
+                return outcome
+    return outcomes[0]
+
+
+def describe_configuration(config):
+    return {'verifier': config.verifier,
+            'solver': config.solver,
+            'options': config.verifier_options}
+
+
+def verify_bpl(args):
+    """Verify the Boogie source file with a back-end verifier."""
+
+    if args.verifier == 'svcomp':
+        verify_bpl_svcomp(args)
+        return
+
+    partitions = entry_point_partitions(args)
+    if partitions:
+        outcomes = run_parallel(verify_partition, partitions, args.jobs)
+        if not args.quiet:
+            for part, outcome in zip(partitions, outcomes):
+                print("%s: %s" % (part.entry_points[0], outcome[1]))
+        config, result, verifier_output = merge_outcomes(outcomes)
+    else:
+        config, result, verifier_output = verify_partition(args)
+
+    extra = {}
+    if args.auto_unroll:
+        extra['unroll'] = config.unroll
+    if args.portfolio:
+        extra['configuration'] = describe_configuration(config)
+        if not args.quiet:
+            print("Portfolio result by %s with %s" %
+                  (config.verifier, config.solver))
+    extra['resources'] = resource_usage.report()
 
     if args.json_file:
         with open(args.json_file, 'w') as f:
-            f.write(json_output_str(result, verifier_output, args.verifier))
+            f.write(json_output_str(result, verifier_output, config.verifier,
+                                    extra=extra))
 
     if result in VResult.ERROR:
-        error = error_trace(verifier_output, args.verifier)
+        error = error_trace(verifier_output, config.verifier)
 
         if args.error_file:
             with open(args.error_file, 'w') as f:
@@ -972,8 +1486,12 @@ def verify_bpl(args):
             print(error)
 
         if args.replay:
-            replay_error_trace(verifier_output, args)
-    print(result.message(args))
+            replay_error_trace(verifier_output, config)
+    if args.verbose and args.cache:
+        print(args.cache.summary())
+    if args.verbose:
+        print(resource_usage.summary())
+    print(result.message(config))
     return result.return_code()
 
 
@@ -1000,7 +1518,8 @@ def main():
 
         if args.no_verify:
             if not args.quiet:
-                print("SMACK generated %s" % args.bpl_file)
+                for part in entry_point_partitions(args) or [args]:
+                    print("SMACK generated %s" % part.bpl_file)
         else:
             return_code = verify_bpl(args)
             sys.exit(return_code)
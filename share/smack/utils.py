@@ -1,10 +1,15 @@
 import os
+import re
+import socket
 import sys
 import shutil
 import tempfile
+import time
+import resource
 import subprocess
 import signal
-from threading import Timer
+from concurrent.futures import ThreadPoolExecutor
+from threading import Lock, Timer
 from . import top
 from .versions import LLVM_SHORT_VERSION
 
@@ -34,13 +39,159 @@ def remove_temp_files():
             shutil.rmtree(f)
 
 
+def derived_file(name, suffix, args):
+    '''Name a file after NAME, e.g., a.bpl becomes a.SUFFIX.bpl; the file is
+    temporary when NAME is.'''
+    base, extension = os.path.splitext(name)
+    derived = '%s.%s%s' % (base, suffix, extension)
+    if name in temporary_files:
+        temporary_files.append(derived)
+    return derived
+
+
+def run_parallel(function, items, jobs):
+    '''Apply FUNCTION to ITEMS with at most JOBS worker threads, each of which
+    drives its own subprocesses, and return the results in order.'''
+    with ThreadPoolExecutor(max_workers=max(jobs, 1)) as pool:
+        return list(pool.map(function, items))
+
+
+class ProcessGroup:
+    '''The subprocesses started by concurrent workers, which are killed at
+    once, e.g., when one of the workers has produced a definitive result.'''
+
+    def __init__(self):
+        self.lock = Lock()
+        self.procs = []
+        self.killed = False
+
+    def add(self, proc):
+        with self.lock:
+            self.procs.append(proc)
+            if self.killed:
+                kill_process(proc)
+
+    def kill(self):
+        with self.lock:
+            self.killed = True
+            for proc in self.procs:
+                kill_process(proc)
+
+
+# Held while a subprocess is reaped, so that it is never killed after its
+# process ID is released.
+reap_lock = Lock()
+
+
+def kill_process(proc):
+    with reap_lock:
+        if proc.returncode is None:
+            try:
+                os.killpg(os.getpgid(proc.pid), signal.SIGKILL)
+            except ProcessLookupError:
+                pass
+
+
+class MemoryLimitExceeded(Exception):
+    pass
+
+
+# The messages with which processes report failed allocations, e.g., when
+# their address space exceeds the memory limit.
+OUT_OF_MEMORY = (r'out of memory|OutOfMemory|bad_alloc|'
+                 r'Cannot allocate memory|MemoryError')
+
+
+class ResourceUsage:
+    '''The resources used by the subprocesses of each stage, i.e., of each
+    command, such as clang, llvm2bpl, or the verifier: their number, their wall
+    time, their user and system time, in seconds, the peak resident set size of
+    any of them, in megabytes, and the number of them which exceeded the memory
+    limit.'''
+
+    def __init__(self):
+        self.lock = Lock()
+        self.stages = {}
+
+    def add(self, cmd, wall, user, system, max_rss, memory_out=False):
+        stage = os.path.basename(cmd[0])
+        with self.lock:
+            s = self.stages.setdefault(stage, {
+                'processes': 0, 'wall': 0.0, 'user': 0.0, 'system': 0.0,
+                'max_rss': 0.0, 'memory_outs': 0})
+            s['processes'] += 1
+            s['wall'] += wall
+            s['user'] += user
+            s['system'] += system
+            s['max_rss'] = max(s['max_rss'], max_rss)
+            s['memory_outs'] += int(memory_out)
+
+    def report(self):
+        with self.lock:
+            return {stage: {k: round(v, 3) for k, v in s.items()}
+                    for stage, s in self.stages.items()}
+
+    def summary(self):
+        lines = ['%s: %d processes, %.2fs wall, %.2fs user, %.2fs system, '
+                 '%.1f MB peak RSS' % (stage, s['processes'], s['wall'],
+                                       s['user'], s['system'], s['max_rss'])
+                 + (', %d out of memory' % s['memory_outs']
+                    if s['memory_outs'] else '')
+                 for stage, s in self.report().items()]
+        return '\n'.join(['resource usage:'] + lines)
+
+
+resource_usage = ResourceUsage()
+
+
+def exit_code(status):
+    if os.WIFSIGNALED(status):
+        return -os.WTERMSIG(status)
+    return os.WEXITSTATUS(status)
+
+
+def reap(proc):
+    '''Wait for the subprocess PROC to exit, set its return code, and return
+    its resource usage, which only wait4 reports. The subprocess is reaped
+    here rather than by Popen, which discards the usage. Where waitid is
+    missing, e.g., on macOS, wait4 polls, since blocking in it while holding
+    reap_lock would block kill_process.'''
+    try:
+        if hasattr(os, 'waitid'):
+            os.waitid(os.P_PID, proc.pid, os.WEXITED | os.WNOWAIT)
+        while True:
+            with reap_lock:
+                pid, status, usage = os.wait4(
+                    proc.pid, 0 if hasattr(os, 'waitid') else os.WNOHANG)
+                if pid:
+                    proc.returncode = exit_code(status)
+                    return usage
+            time.sleep(0.01)
+    except ChildProcessError:
+        proc.wait()
+        return None
+
+
+def process_setup(memory_limit):
+    '''The setup of each subprocess: its own process group, so that it can be
+    killed with its descendants, and a limit on its address space, in
+    megabytes, which they inherit.'''
+    def setup():
+        os.setsid()
+        if memory_limit:
+            limit = memory_limit << 20
+            resource.setrlimit(resource.RLIMIT_AS, (limit, limit))
+    return setup
+
+
 def timeout_killer(proc, timed_out):
     if not timed_out[0]:
         timed_out[0] = True
-        os.killpg(os.getpgid(proc.pid), signal.SIGKILL)
+        kill_process(proc)
 
 
-def try_command(cmd, cwd=None, console=False, timeout=None, env=None):
+def try_command(cmd, cwd=None, console=False, timeout=None, env=None,
+                group=None):
     args = top.args
     console = (console or args.verbose or args.debug) and not args.quiet
     filelog = args.debug
@@ -54,38 +205,50 @@ def try_command(cmd, cwd=None, console=False, timeout=None, env=None):
         if args.debug:
             print("Running %s" % " ".join(cmd))
 
+        memory_limit = getattr(args, 'memory_limit', None)
+        start = time.time()
         proc = subprocess.Popen(
             cmd,
             cwd=cwd,
-            preexec_fn=os.setsid,
+            preexec_fn=process_setup(memory_limit),
             stdout=subprocess.PIPE,
             stderr=subprocess.STDOUT,
             universal_newlines=True)
 
+        if group:
+            group.add(proc)
+
         if timeout:
             timed_out = [False]
             timer = Timer(timeout, timeout_killer, [proc, timed_out])
             timer.start()
 
         if console:
-            while True:
-                line = proc.stdout.readline()
-                if line:
-                    output += line
-                    print(line, end='')
-                elif proc.poll() is not None:
-                    break
-            proc.wait
+            for line in proc.stdout:
+                output += line
+                print(line, end='')
         else:
-            output = proc.communicate()[0]
+            output = proc.stdout.read()
+        proc.stdout.close()
+        usage = reap(proc)
 
         if timeout:
             timer.cancel()
 
         rc = proc.returncode
         proc = None
+        memory_out = bool(memory_limit and rc and
+                          re.search(OUT_OF_MEMORY, output))
+        if usage:
+            resource_usage.add(cmd, time.time() - start, usage.ru_utime,
+                               usage.ru_stime, usage.ru_maxrss / 1024,
+                               memory_out)
         if timeout and timed_out[0]:
             return output + ("\n%s timed out." % cmd[0])
+        elif memory_out:
+            raise MemoryLimitExceeded(
+                output + ("\n%s exceeded the memory limit of %d MB." %
+                          (cmd[0], memory_limit)))
         elif rc == -signal.SIGSEGV:
             raise Exception("segmentation fault")
         elif rc and args.verifier != 'symbooglix':
@@ -101,11 +264,57 @@ def try_command(cmd, cwd=None, console=False, timeout=None, env=None):
         if timeout and timer:
             timer.cancel()
         if proc:
-            os.killpg(os.getpgid(proc.pid), signal.SIGKILL)
+            kill_process(proc)
         if filelog:
             with open(temporary_file(cmd[0], '.log', args), 'w') as f:
                 f.write(output)
 
 
+def try_server(path, cmd, console=False):
+    '''Run CMD on the server listening on the Unix socket PATH, e.g.,
+    llvm2bpl --serve PATH, and return its output, or None when no server is
+    listening.'''
+    args = top.args
+    console = (console or args.verbose or args.debug) and not args.quiet
+    try:
+        conn = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        conn.connect(path)
+    except OSError:
+        return None
+
+    start = time.time()
+    with conn:
+        if args.debug:
+            print("Running %s on %s" % (" ".join(cmd), path))
+        request = [os.getcwd()] + cmd
+        conn.sendall(b''.join(f.encode() + b'\0' for f in request))
+        conn.shutdown(socket.SHUT_WR)
+        chunks = []
+        while True:
+            chunk = conn.recv(1 << 16)
+            if not chunk:
+                break
+            chunks.append(chunk)
+
+    output = b''.join(chunks).decode(errors='replace')
+    m = re.search(r'^%s-exit: (\d+)\n\Z' % re.escape(cmd[0]), output, re.M)
+    if not m:
+        raise Exception("%s server closed the connection\n%s" %
+                        (cmd[0], output))
+    exit_code = int(m.group(1))
+    output = output[:m.start()]
+    m = re.search(r'^%s-usage: ([\d.]+) ([\d.]+) (\d+)\n\Z' %
+                  re.escape(cmd[0]), output, re.M)
+    if m:
+        resource_usage.add(cmd, time.time() - start, float(m.group(1)),
+                           float(m.group(2)), int(m.group(3)) / 1024)
+        output = output[:m.start()]
+    if console:
+        print(output, end='')
+    if exit_code:
+        raise Exception(output)
+    return output
+
+
 def llvm_exact_bin(name):
     return name + '-' + LLVM_SHORT_VERSION
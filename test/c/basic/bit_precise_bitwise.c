@@ -0,0 +1,14 @@
+#include "smack.h"
+
+// @expect verified
+// @flag --bit-precise-bitwise-ops
+
+int main(void) {
+  int x = __VERIFIER_nondet_int();
+  int y = x & 0xff;
+  assert(0 <= y && y < 256);
+  assert((x ^ x) == 0);
+  assert((-8 & -4) == -8);
+  assert(((unsigned)x >> 28) < 16);
+  return 0;
+}
@@ -0,0 +1,11 @@
+#include "smack.h"
+
+// @expect error
+// @flag --bit-precise-bitwise-ops
+
+int main(void) {
+  int x = __VERIFIER_nondet_int();
+  int y = x & 0xff;
+  assert(y < 255);
+  return 0;
+}
@@ -0,0 +1,22 @@
+#include "smack.h"
+
+// @expect verified
+// @flag --bit-precise-bitwise-ops
+
+// The integer encoding keeps no signedness, so results are read as signed
+// when an operand (the shifted value, for shifts) is negative.
+
+int main(void) {
+  int x = __VERIFIER_nondet_int();
+  int y = __VERIFIER_nondet_int();
+  assume(x == -5);
+  assume(y < 0);
+  assert((x & 3) == 3);
+  assert((x | 2) == -5);
+  assert((x ^ -1) == 4);
+  assert((x >> 1) == -3);
+  assert((x & y) < 0);
+  assert((x | y) < 0);
+  assert((x ^ y) >= 0);
+  return 0;
+}
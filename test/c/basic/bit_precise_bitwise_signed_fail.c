@@ -0,0 +1,11 @@
+#include "smack.h"
+
+// @expect error
+// @flag --bit-precise-bitwise-ops
+
+int main(void) {
+  int x = __VERIFIER_nondet_int();
+  assume(x == -5);
+  assert((x >> 1) == -2);
+  return 0;
+}
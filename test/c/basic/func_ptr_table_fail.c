@@ -0,0 +1,32 @@
+#include "smack.h"
+#include <assert.h>
+
+// @expect error
+
+struct dev {
+  int state;
+};
+
+void open_dev(struct dev *d) { d->state = 1; }
+void close_dev(struct dev *d) { d->state = 0; }
+void reset_dev(struct dev *d) { d->state = 2; }
+
+void log_a(int *x) { *x = 10; }
+void log_b(int *x) { *x = 20; }
+
+void (*dev_ops[3])(struct dev *) = {open_dev, close_dev, reset_dev};
+void (*log_ops[2])(int *) = {log_a, log_b};
+
+int main(void) {
+  struct dev d;
+  int x = 0;
+  int i = __VERIFIER_nondet_int();
+  int j = __VERIFIER_nondet_int();
+  assume(i >= 0 && i < 3);
+  assume(j >= 0 && j < 2);
+  dev_ops[i](&d);
+  log_ops[j](&x);
+  assert(d.state >= 0 && d.state <= 2);
+  assert(x == 10);
+  return 0;
+}
@@ -0,0 +1,26 @@
+#include "smack.h"
+#include <assert.h>
+
+// @flag --inline-leaf-functions --checked-functions main get_x
+// @checkbpl grep -E 'call .* := get_x\('
+// @checkbpl sh -c "! grep -E 'set_y\('"
+// @expect error
+
+// Checked functions keep their procedures, so that their properties are
+// checked where they are.
+
+struct point {
+  int x;
+  int y;
+};
+
+int get_x(struct point *p) { return p->x; }
+void set_y(struct point *p, int y) { p->y = y; }
+
+int main(void) {
+  struct point p;
+  p.x = __VERIFIER_nondet_int();
+  set_y(&p, get_x(&p) + 1);
+  assert(p.y == p.x + 2);
+  return 0;
+}
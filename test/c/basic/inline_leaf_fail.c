@@ -0,0 +1,33 @@
+#include "smack.h"
+#include <assert.h>
+
+// @flag --inline-leaf-functions
+// @checkbpl sh -c "! grep -E '(get_x|set_y)\('"
+// @checkbpl grep -E 'call .* := sum\('
+// @expect error
+
+struct point {
+  int x;
+  int y;
+};
+
+int get_x(struct point *p) { return p->x; }
+void set_y(struct point *p, int y) { p->y = y; }
+
+// Not a leaf, since it has a loop.
+int sum(int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    s += i;
+  return s;
+}
+
+int main(void) {
+  struct point p;
+  p.x = __VERIFIER_nondet_int();
+  assume(p.x > 0 && p.x < 4);
+  set_y(&p, get_x(&p) + 1);
+  assert(p.y == p.x + 1);
+  assert(sum(p.x) < 3);
+  return 0;
+}
@@ -0,0 +1,22 @@
+#include "smack.h"
+#include <assert.h>
+
+// @expect error
+// @flag --infer-loop-invariants
+// @checkbpl grep -E 'assert \{:loopinvariant\} .*\$i[0-9]+ >= 0\)'
+// @checkbpl grep -E 'assume \{:loopinvariant\} .*\$i[0-9]+ >= 0\)'
+// @flag --unroll=2
+
+int main(void) {
+  int n = __VERIFIER_nondet_int();
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    assert(i >= 0);
+    assert(i < n);
+    for (int j = 0; j < 100; j++) {
+      assert(j < 1);
+      s++;
+    }
+  }
+  return 0;
+}
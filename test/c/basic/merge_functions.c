@@ -0,0 +1,28 @@
+#include "smack.h"
+#include <assert.h>
+
+// @flag --merge-functions
+// @expect verified
+
+struct int_box {
+  int len;
+  int val;
+};
+
+struct uint_box {
+  int len;
+  unsigned val;
+};
+
+int int_box_len(struct int_box *b) { return b->len; }
+int uint_box_len(struct uint_box *b) { return b->len; }
+
+int main(void) {
+  struct int_box x;
+  struct uint_box y;
+  x.len = __VERIFIER_nondet_int();
+  y.len = x.len + 1;
+  assume(x.len >= 0 && x.len < 100);
+  assert(int_box_len(&x) < uint_box_len(&y));
+  return 0;
+}
@@ -0,0 +1,26 @@
+#include "smack.h"
+#include <assert.h>
+
+// @flag --merge-functions
+// @expect verified
+// @checkbpl awk '/^procedure .*uint_box_len\(/{p=1} p&&/call .* := int_box_len\(/{f=1} /^}/{p=0} END{exit !f}'
+
+struct int_box {
+  int len;
+  int val;
+};
+
+struct uint_box {
+  int len;
+  unsigned val;
+};
+
+int int_box_len(struct int_box *b) { return b->len; }
+int uint_box_len(struct uint_box *b) { return b->len; }
+
+int main(void) {
+  struct int_box x;
+  x.len = __VERIFIER_nondet_int();
+  assert(int_box_len(&x) == uint_box_len((struct uint_box *)&x));
+  return 0;
+}
@@ -0,0 +1,31 @@
+#include "smack.h"
+#include <assert.h>
+
+// @flag --entry-points push_harness pop_harness --split-entry-points
+// @expect verified
+
+#define SIZE 4
+
+int stack[SIZE];
+int top;
+
+void push(int x) {
+  if (top < SIZE)
+    stack[top++] = x;
+}
+
+int pop(void) { return top > 0 ? stack[--top] : 0; }
+
+void push_harness(void) {
+  top = 0;
+  push(1);
+  push(2);
+  assert(top == 2 && stack[1] == 2);
+}
+
+void pop_harness(void) {
+  top = 0;
+  push(3);
+  assert(pop() == 3);
+  assert(pop() == 0);
+}
@@ -0,0 +1,13 @@
+#include "smack.h"
+#include <assert.h>
+
+// @flag --unroll=auto --max-unroll=8
+// @expect verified
+
+int main(void) {
+  int a[6];
+  for (int i = 0; i < 6; i++)
+    a[i] = i;
+  assert(a[5] == 5);
+  return 0;
+}
@@ -0,0 +1,20 @@
+#include "smack.h"
+#include <assert.h>
+
+// @expect verified
+// @flag --integer-encoding=wrapped-integer
+// @flag --unroll=11
+// @checkbpl grep -E ':= \(if \(\$i[0-9]+ < 10\) then 1 else 0\)'
+// @checkbpl grep -E ':= \$idiv\.i32\(\$i[0-9]+, 2\)'
+
+int main(void) {
+  unsigned char c = 250;
+  unsigned s = 0;
+  for (int i = 0; i < 10; i++) {
+    s += (unsigned)i / 2;
+    c++;
+  }
+  assert(s == 20);
+  assert(c == 4);
+  return 0;
+}
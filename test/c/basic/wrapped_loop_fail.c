@@ -0,0 +1,18 @@
+#include "smack.h"
+#include <assert.h>
+
+// @expect error
+// @flag --integer-encoding=wrapped-integer
+// @flag --unroll=11
+
+int main(void) {
+  unsigned char c = 250;
+  unsigned s = 0;
+  for (int i = 0; i < 10; i++) {
+    s += (unsigned)i / 2;
+    c++;
+  }
+  assert(s == 20);
+  assert(c == 260);
+  return 0;
+}
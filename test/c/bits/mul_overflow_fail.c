@@ -0,0 +1,12 @@
+#include "smack.h"
+
+// @expect error
+// @flag --check=integer-overflow
+
+int main(void) {
+  int x = __VERIFIER_nondet_int();
+  int y = __VERIFIER_nondet_int();
+  assume(-46340 <= x && x <= 46341);
+  assume(-46340 <= y && y <= 46341);
+  return x * y;
+}
@@ -0,0 +1,15 @@
+#include "smack.h"
+
+// @flag --unroll=17
+// @expect verified
+
+int main(void) {
+  unsigned char a[16];
+  long sum = 0;
+  for (int i = 0; i < 16; i++)
+    a[i] = i * 3;
+  for (int i = 0; i < 16; i++)
+    sum += a[i];
+  assert(sum == 360);
+  return 0;
+}
@@ -0,0 +1,17 @@
+#include "smack.h"
+
+// @flag --infer-loop-invariants
+// @checkbpl grep -E 'assert \{:loopinvariant\} .* <= \$i[0-9]+\)'
+// @expect error
+
+// Verified without unrolling, which needs the inferred invariant i <= n.
+
+int main(void) {
+  int n = __VERIFIER_nondet_int();
+  assume(n >= 0);
+  int i = 0;
+  while (i < n)
+    i++;
+  assert(i < n);
+  return 0;
+}
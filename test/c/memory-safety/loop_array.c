@@ -0,0 +1,17 @@
+#include "smack.h"
+#include <stdlib.h>
+
+// @flag --unroll=4
+// @expect verified
+
+int main(void) {
+  unsigned n = __VERIFIER_nondet_unsigned();
+  assume(n > 0 && n < 4);
+  int *a = malloc(n * sizeof(int));
+  for (unsigned i = 0; i < n; i++)
+    a[i] = i;
+  for (unsigned i = n; i > 0; i--)
+    a[i - 1] += a[i - 1];
+  free(a);
+  return 0;
+}
@@ -0,0 +1,15 @@
+#include "smack.h"
+#include <stdlib.h>
+
+// @flag --unroll=4
+// @expect error
+
+int main(void) {
+  unsigned n = __VERIFIER_nondet_unsigned();
+  assume(n > 0 && n < 4);
+  int *a = malloc(n * sizeof(int));
+  for (unsigned i = 0; i <= n; i++)
+    a[i] = i;
+  free(a);
+  return 0;
+}
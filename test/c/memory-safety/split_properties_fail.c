@@ -0,0 +1,18 @@
+#include "smack.h"
+#include <assert.h>
+#include <stdlib.h>
+
+// @flag --check memory-safety integer-overflow --split-properties
+// @expect error
+
+int main(void) {
+  int n = __VERIFIER_nondet_int();
+  assume(n > 0 && n < 8);
+  int *a = malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++)
+    a[i] = i + 1;
+  int s = a[0] + a[n];
+  free(a);
+  assert(s == n + 1);
+  return 0;
+}
@@ -0,0 +1,12 @@
+#include "smack.h"
+#include <stdlib.h>
+
+// @expect error
+
+int main(void) {
+  int *a = malloc(2 * sizeof(int));
+  a[0] = 1;
+  a[1] = 2;
+  free(a);
+  return a[0];
+}
@@ -0,0 +1,14 @@
+#include "smack.h"
+
+// @expect error
+// @checkout grep -E "Portfolio result by (corral|boogie) with z3"
+
+int main(void) {
+  int x = __VERIFIER_nondet_int();
+  int y = x;
+  assume(x > 0 && x < 100);
+  while (y > 0)
+    y--;
+  assert(x < y);
+  return 0;
+}
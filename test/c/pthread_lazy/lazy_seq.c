@@ -0,0 +1,29 @@
+#include "smack.h"
+#include <assert.h>
+#include <pthread.h>
+
+// @expect verified
+
+// Within the three rounds in which the lost update of lazy_seq_fail.c is
+// reachable, the lock rules it out.
+
+int x = 0;
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+void *t1(void *arg) {
+  pthread_mutex_lock(&lock);
+  int y = x;
+  x = y + 1;
+  pthread_mutex_unlock(&lock);
+  return 0;
+}
+
+int main(void) {
+  pthread_t tid1, tid2;
+  pthread_create(&tid1, 0, t1, 0);
+  pthread_create(&tid2, 0, t1, 0);
+  pthread_join(tid1, 0);
+  pthread_join(tid2, 0);
+  assert(x == 2);
+  return 0;
+}
@@ -0,0 +1,28 @@
+#include "smack.h"
+#include <assert.h>
+#include <pthread.h>
+
+// @expect error
+
+// The lost update needs three rounds, since main runs first in each round:
+// in the first, the first thread reads x and is suspended, and the second
+// runs to completion; in the second, main waits on the join, and the first
+// thread writes x; only in the third does main reach the assertion.
+
+int x = 0;
+
+void *t1(void *arg) {
+  int y = x;
+  x = y + 1;
+  return 0;
+}
+
+int main(void) {
+  pthread_t tid1, tid2;
+  pthread_create(&tid1, 0, t1, 0);
+  pthread_create(&tid2, 0, t1, 0);
+  pthread_join(tid1, 0);
+  pthread_join(tid2, 0);
+  assert(x == 2);
+  return 0;
+}
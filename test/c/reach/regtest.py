@@ -4,6 +4,7 @@ import subprocess
 import re
 import time
 import json
+import sys
 
 # list of regression tests with the expected outputs
 #   (filename, loop unroll)
@@ -31,6 +32,19 @@ tests = [
   ('return',            1),
 ]
 
+# verifier configurations, each with its extra arguments; the last checks
+# 4 lines per corral run, with 2 runs in parallel
+configurations = [
+  ('boogie', []),
+  ('corral', []),
+  ('corral', ['--batch-size=4', '--batch-jobs=2']),
+]
+
+# The expected outputs also list lines of smack.h, under the path of the
+# installation they were recorded with, so only the test's own are compared.
+def unreachable(test, output):
+  return json.loads(output).get(test + '.c')
+
 def red(text):
   return '\033[0;31m' + text + '\033[0m'
   
@@ -40,27 +54,29 @@ def green(text):
 def runtests():
   passed = failed = 0
   for test in tests:
-    for verifier in ['boogie-inline', 'corral']:
+    for verifier, extra in configurations:
 
       ansFile = open(test[0] + ".expected")
       expected = ansFile.read()
       ansFile.close()
 
-      print("{0:>20} {1:>16}:".format(test[0], "(" + verifier + ")"))
+      name = " ".join([verifier] + extra)
+      print("{0:>20} {1:>16}:".format(test[0], "(" + name + ")"))
 
       # invoke smack-reach
       t0 = time.time()
-      p = subprocess.Popen(['smackreach.py', test[0] + '.c',
+      p = subprocess.Popen(['smack-reach', test[0] + '.c',
                             '--verifier=' + verifier,
-                            '--unroll=' + str(test[1]), 
-                            '-o', test[0] +'.bpl', '--smackd'],
+                            '--unroll=' + str(test[1]),
+                            '--smackd'] + extra,
                            stdout=subprocess.PIPE, universal_newlines=True)
       
       smackOutput = p.communicate()[0]
       elapsed = time.time() - t0
 
       # check SMACK output
-      if(json.loads(expected) == json.loads(smackOutput)):
+      if(unreachable(test[0], expected) ==
+         unreachable(test[0], smackOutput)):
         print(green('PASSED') + '  [%.2fs]' % round(elapsed, 2))
         passed += 1
       else:
@@ -75,3 +91,4 @@ if __name__ == '__main__':
   
   print('\nPASSED count: ', passed)
   print('FAILED count: ', failed)
+  sys.exit(1 if failed else 0)
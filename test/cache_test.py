@@ -0,0 +1,128 @@
+#! /usr/bin/env python3
+
+from os import path
+import os
+import shutil
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, path.join(path.dirname(path.abspath(__file__)),
+                             '..', 'share', 'smack'))
+import cache  # noqa: E402
+
+
+def write(name, text):
+    with open(name, 'w') as f:
+        f.write(text)
+
+
+class ResultCacheTest(unittest.TestCase):
+
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.bin = path.join(self.dir, 'bin')
+        os.makedirs(self.bin)
+        self.path = os.environ['PATH']
+        os.environ['PATH'] = self.bin + os.pathsep + self.path
+        cache.binaries.clear()
+
+        # A verifier launched by a script, as symbooglix is.
+        write(path.join(self.bin, 'verifier.exe'), 'v1')
+        self.tool('verifier', '#!/bin/sh\n'
+                  'exec mono $(dirname $0)/verifier.exe "$@"\n')
+        self.tool('z3', '')
+        self.tool('cvc4', '')
+
+        self.bpl = path.join(self.dir, 'a.bpl')
+        write(self.bpl, 'procedure main() { }\n')
+        self.cache = cache.ResultCache(path.join(self.dir, 'cache'), 1 << 20)
+
+    def tearDown(self):
+        os.environ['PATH'] = self.path
+        cache.binaries.clear()
+        shutil.rmtree(self.dir)
+
+    def tool(self, name, text):
+        name = path.join(self.bin, name)
+        write(name, text)
+        os.chmod(name, 0o755)
+
+    def key(self, solver='z3'):
+        cache.binaries.clear()
+        return self.cache.key(self.bpl, ['verifier', self.bpl, '/k:1'],
+                              [solver])
+
+    def test_miss_and_hit(self):
+        key = self.key()
+        self.assertIsNone(self.cache.lookup(key, self.bpl))
+        self.cache.store(key, self.bpl, 'ERROR', self.bpl + '(3,1): error')
+        other = path.join(self.dir, 'b.bpl')
+        self.assertEqual(self.cache.lookup(key, other),
+                         ('ERROR', other + '(3,1): error'))
+        self.assertEqual((self.cache.hits, self.cache.misses), (1, 1))
+
+    def test_key(self):
+        key = self.key()
+        self.assertEqual(key, self.key())
+        self.assertNotEqual(key, self.key('cvc4'))
+        self.assertNotEqual(key, self.cache.key(
+            self.bpl, ['verifier', self.bpl, '/k:2'], ['z3']))
+
+        write(self.bpl, 'procedure main() { assert false; }\n')
+        self.assertNotEqual(key, self.key())
+
+    def test_key_of_launched_assembly(self):
+        key = self.key()
+        write(path.join(self.bin, 'verifier.exe'), 'v2.0')
+        self.assertNotEqual(key, self.key())
+
+    def test_key_of_dotnet_tool(self):
+        store = path.join(self.bin, '.store', 'verifier', '1.0')
+        os.makedirs(store)
+        write(path.join(store, 'Verifier.dll'), 'v1')
+        key = self.key()
+        write(path.join(store, 'Verifier.dll'), 'v2.0')
+        self.assertNotEqual(key, self.key())
+
+    def test_eviction(self):
+        keys = [self.key(s) for s in ['z3', 'cvc4']]
+        self.cache.store(keys[0], self.bpl, 'VERIFIED', 'verified')
+        size = path.getsize(self.cache.path(keys[0]))
+        self.cache.max_size = 2 * size + size // 2
+        os.utime(self.cache.path(keys[0]), (100, 100))
+        self.cache.store(keys[1], self.bpl, 'VERIFIED', 'verified')
+        os.utime(self.cache.path(keys[1]), (200, 200))
+
+        # The least recently used entry is evicted first.
+        self.assertIsNotNone(self.cache.lookup(keys[0], self.bpl))
+        key = self.cache.key(self.bpl, ['verifier', self.bpl], ['z3'])
+        self.cache.store(key, self.bpl, 'VERIFIED', 'verified')
+        self.assertIsNotNone(self.cache.lookup(keys[0], self.bpl))
+        self.assertIsNone(self.cache.lookup(keys[1], self.bpl))
+        self.assertIsNotNone(self.cache.lookup(key, self.bpl))
+
+    def test_eviction_of_results_only(self):
+        lib = path.join(self.dir, 'cache', 'lib', 'a.bc')
+        os.makedirs(path.dirname(lib))
+        write(lib, 'x' * 4096)
+        os.utime(lib, (100, 100))
+        self.cache.max_size = 1024
+        key = self.key()
+        self.cache.store(key, self.bpl, 'VERIFIED', 'verified')
+        self.assertTrue(path.isfile(lib))
+        self.assertIsNotNone(self.cache.lookup(key, self.bpl))
+
+    def test_link_or_copy(self):
+        source = path.join(self.dir, 'a.bc')
+        target = path.join(self.dir, 'b.bc')
+        write(source, 'a')
+        write(target, 'b')
+        cache.link_or_copy(source, target)
+        os.unlink(source)
+        with open(target) as f:
+            self.assertEqual(f.read(), 'a')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -10,6 +10,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/LinkAllPasses.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
@@ -33,9 +34,14 @@
 #include "smack/CodifyStaticInits.h"
 #include "smack/ExtractContracts.h"
 #include "smack/InitializePasses.h"
+#include "smack/InlineLeafFunctions.h"
 #include "smack/IntegerOverflowChecker.h"
+#include "smack/IntegerWrapElimination.h"
+#include "smack/LazySequentialization.h"
 #include "smack/MemorySafetyChecker.h"
+#include "smack/MergeIdenticalFunctions.h"
 #include "smack/Naming.h"
+#include "smack/NarrowIntegerOps.h"
 #include "smack/NormalizeLoops.h"
 #include "smack/RemoveDeadDefs.h"
 #include "smack/RewriteBitwiseOps.h"
@@ -51,10 +57,17 @@
 #include "utils/SimplifyExtractValue.h"
 #include "utils/SimplifyInsertValue.h"
 
-static llvm::cl::opt<std::string>
-    InputFilename(llvm::cl::Positional,
-                  llvm::cl::desc("<input LLVM bitcode file>"),
-                  llvm::cl::Required, llvm::cl::value_desc("filename"));
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static llvm::cl::list<std::string>
+    InputFilenames(llvm::cl::Positional,
+                   llvm::cl::desc("<input LLVM bitcode files>"),
+                   llvm::cl::OneOrMore, llvm::cl::value_desc("filenames"));
 
 static llvm::cl::opt<std::string>
     OutputFilename("bpl", llvm::cl::desc("Output Boogie filename"),
@@ -120,28 +133,43 @@ static TargetMachine *GetTargetMachine(Triple TheTriple, StringRef CPUStr,
 }
 } // namespace
 
-int main(int argc, char **argv) {
-  llvm::llvm_shutdown_obj shutdown; // calls llvm_shutdown() on exit
+// Initializes the targets and the analyses, once per process.
+static void initialize() {
+  InitializeAllTargets();
+  InitializeAllTargetMCs();
+  InitializeAllAsmPrinters();
+  InitializeAllAsmParsers();
+
+  llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
+  llvm::initializeAnalysis(Registry);
+
+  llvm::initializeCodifyStaticInitsPass(Registry);
+  llvm::initializeDevirtualizePass(Registry);
+  llvm::initializeRemovePtrToIntPass(Registry);
+}
+
+static int translate(int argc, char **argv) {
   llvm::cl::ParseCommandLineOptions(
       argc, argv, "llvm2bpl - LLVM bitcode to Boogie transformation\n");
 
-  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
-  llvm::PrettyStackTraceProgram PSTP(argc, argv);
-  llvm::EnableDebugBuffering = true;
-
   llvm::SMDiagnostic err;
   llvm::LLVMContext Context;
 
-  InitializeAllTargets();
-  InitializeAllTargetMCs();
-  InitializeAllAsmPrinters();
-  InitializeAllAsmParsers();
-
   std::unique_ptr<llvm::Module> module =
-      llvm::parseIRFile(InputFilename, err, Context);
+      llvm::parseIRFile(InputFilenames.front(), err, Context);
   if (!err.getMessage().empty())
     check("Problem reading input bitcode/IR: " + err.getMessage().str());
 
+  // Further inputs, e.g., the SMACK libraries, are linked in memory, in order.
+  llvm::Linker linker(*module);
+  for (unsigned i = 1; i < InputFilenames.size(); ++i) {
+    auto M = llvm::parseIRFile(InputFilenames[i], err, Context);
+    if (!err.getMessage().empty())
+      check("Problem reading input bitcode/IR: " + err.getMessage().str());
+    if (linker.linkInModule(std::move(M)))
+      check("Problem linking input bitcode/IR: " + InputFilenames[i]);
+  }
+
   auto &L = module.get()->getDataLayoutStr();
   if (L.empty())
     module.get()->setDataLayout(DefaultDataLayout);
@@ -150,16 +178,9 @@ int main(int argc, char **argv) {
       smack::SmackWarnings::WarningLevel::Info)
     seadsa::SeaDsaEnableLog("dsa-warn");
 
-  ///////////////////////////////
-  // initialise and run passes //
-  ///////////////////////////////
-
-  llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
-  llvm::initializeAnalysis(Registry);
-
-  llvm::initializeCodifyStaticInitsPass(Registry);
-  llvm::initializeDevirtualizePass(Registry);
-  llvm::initializeRemovePtrToIntPass(Registry);
+  ////////////////
+  // run passes //
+  ////////////////
 
   llvm::legacy::PassManager pass_manager;
 
@@ -188,6 +209,15 @@ int main(int argc, char **argv) {
   // pass_manager.add(llvm::createInternalizePass());
   pass_manager.add(llvm::createPromoteMemoryToRegisterPass());
 
+  if (smack::SmackOptions::ScalarizeVectors) {
+    // The scalarizer leaves vector loads and stores intact unless given
+    // -scalarize-load-store, which the driver passes along. The remaining
+    // vector values, e.g., function arguments, are translated with the vector
+    // datatypes of VectorOperations.
+    pass_manager.add(llvm::createScalarizerPass());
+    pass_manager.add(llvm::createDeadCodeEliminationPass());
+  }
+
   if (StaticUnroll) {
     pass_manager.add(llvm::createLoopSimplifyPass());
     pass_manager.add(llvm::createLoopRotatePass());
@@ -214,18 +244,36 @@ int main(int argc, char **argv) {
   pass_manager.add(new llvm::Devirtualize());
   pass_manager.add(new smack::SplitAggregateValue());
 
+  if (smack::SmackOptions::MergeFunctions)
+    pass_manager.add(new smack::MergeIdenticalFunctions());
+
+  if (smack::SmackOptions::LazySequentialization)
+    pass_manager.add(new smack::LazySequentialization());
+
   if (smack::SmackOptions::MemorySafety) {
     pass_manager.add(new smack::MemorySafetyChecker());
   }
 
   pass_manager.add(new smack::IntegerOverflowChecker());
 
+  if (smack::SmackOptions::InlineLeafFunctions) {
+    pass_manager.add(new smack::InlineLeafFunctions());
+    if (!Modular)
+      pass_manager.add(new smack::RemoveDeadDefs());
+  }
+
+  if (smack::SmackOptions::BitPrecise)
+    pass_manager.add(new smack::NarrowIntegerOps());
+
   if (smack::SmackOptions::RewriteBitwiseOps &&
       !(smack::SmackOptions::BitPrecise ||
         smack::SmackOptions::BitPrecisePointers)) {
     pass_manager.add(new smack::RewriteBitwiseOps());
   }
 
+  if (smack::SmackOptions::WrappedIntegerEncoding)
+    pass_manager.add(new smack::IntegerWrapElimination());
+
   if (smack::SmackOptions::AddTiming) {
     Triple ModuleTriple(module->getTargetTriple());
     assert(
@@ -280,3 +328,111 @@ int main(int argc, char **argv) {
 
   return 0;
 }
+
+// Reads a translation request, i.e., the working directory followed by the
+// command-line arguments, each terminated by a null character, up to the end
+// of the stream.
+static std::vector<std::string> readRequest(int fd) {
+  std::string data;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+    data.append(buffer, n);
+
+  std::vector<std::string> fields;
+  for (size_t i = 0, j; (j = data.find('\0', i)) != std::string::npos; i = j + 1)
+    fields.push_back(data.substr(i, j - i));
+  return fields;
+}
+
+// Translates the request on the connection in a child process, whose output
+// is sent back, followed by a line with its resource usage, i.e., its user
+// and system time in seconds and its peak resident set size in kilobytes, and
+// a line with its exit status.
+static void handle(int conn) {
+  auto request = readRequest(conn);
+  if (request.size() < 2 || chdir(request[0].c_str()) != 0) {
+    dprintf(conn, "llvm2bpl: invalid request\nllvm2bpl-exit: 1\n");
+    return;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(conn, STDOUT_FILENO);
+    dup2(conn, STDERR_FILENO);
+    close(conn);
+    std::vector<char *> argv;
+    for (auto I = request.begin() + 1; I != request.end(); ++I)
+      argv.push_back(&(*I)[0]);
+    argv.push_back(nullptr);
+    int status = translate(argv.size() - 1, argv.data());
+    outs().flush();
+    errs().flush();
+    exit(status);
+  }
+
+  int status = 1;
+  struct rusage usage = {};
+  if (pid < 0 || wait4(pid, &status, 0, &usage) < 0)
+    status = 1;
+  else if (WIFSIGNALED(status))
+    status = 128 + WTERMSIG(status);
+  else
+    status = WEXITSTATUS(status);
+  dprintf(conn, "llvm2bpl-usage: %ld.%06ld %ld.%06ld %ld\n",
+          (long)usage.ru_utime.tv_sec, (long)usage.ru_utime.tv_usec,
+          (long)usage.ru_stime.tv_sec, (long)usage.ru_stime.tv_usec,
+          usage.ru_maxrss);
+  dprintf(conn, "llvm2bpl-exit: %d\n", status);
+}
+
+// Serves translation requests on a Unix domain socket. The process is
+// initialized once, and each request is handled by a process forked from it,
+// concurrently, so that the options and the state of the translation of each
+// request are its own.
+static int serve(const char *path) {
+  struct sockaddr_un addr;
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path))
+    check(std::string("Socket path too long: ") + path);
+  strcpy(addr.sun_path, path);
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if (sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(sock, SOMAXCONN) < 0)
+    check(std::string("Cannot listen on ") + path + ": " + strerror(errno));
+
+  // Handlers are reaped automatically.
+  signal(SIGCHLD, SIG_IGN);
+  while (true) {
+    int conn = accept(sock, nullptr, nullptr);
+    if (conn < 0)
+      continue;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(sock);
+      signal(SIGCHLD, SIG_DFL);
+      handle(conn);
+      close(conn);
+      _exit(0);
+    }
+    close(conn);
+  }
+}
+
+int main(int argc, char **argv) {
+  llvm::llvm_shutdown_obj shutdown; // calls llvm_shutdown() on exit
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::PrettyStackTraceProgram PSTP(argc, argv);
+  llvm::EnableDebugBuffering = true;
+
+  initialize();
+
+  if (argc == 3 && (StringRef(argv[1]) == "-serve" ||
+                    StringRef(argv[1]) == "--serve"))
+    return serve(argv[2]);
+
+  return translate(argc, argv);
+}